@@ -2,10 +2,15 @@
 out vec4 frag_color;
 
 in vec3 _position;
-in vec3 _normal;
+in vec3 _world_position;
 in vec3 _color;
 
 void main() {
+	//the flat normal of the triangle, its vertices are shared so it can't come from them.
+	//the derivatives give the side facing the camera, flipping back faces orients it by the winding
+	vec3 _normal = normalize(cross(dFdx(_world_position), dFdy(_world_position)));
+	if (!gl_FrontFacing) _normal = -_normal;
+
 	vec3 directional_lights[4] = vec3[4](vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0), vec3(0.0, 0.0, -1.0));
 	float lighting_mult = 0.0f;
 
@@ -0,0 +1,288 @@
+#ifndef CRENGINE_PUBLIC_HEADER_GEOMETRY
+#define CRENGINE_PUBLIC_HEADER_GEOMETRY
+
+#include <CREngine/Math.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace CREngine {
+	namespace Geometry {
+		/*
+		a uniform hash grid of point ids.
+		every id is stored in the cell that contains its position, so all the points within
+		cell_size of a position are found by visiting the 27 cells around it.
+		*/
+		class PointGrid {
+			private:
+				struct Slot {
+					uint64_t key;
+					int head;		//first id in the cell, -1 for an empty slot
+				};
+
+				float inverse_cell_size;
+				std::vector<Slot> slots;		//open addressing, the size is a power of 2
+				std::vector<int> next;			//next id in the same cell, indexed by id
+				int used_slots;
+
+				static uint64_t cell_key(int x, int y, int z);
+				int find_slot(uint64_t key) const;
+				void grow();
+
+			public:
+				PointGrid(float cell_size, int expected_points = 0);
+
+				void insert(const Math::Vector3D &position, int id);
+
+				//inserts id into the cell (dx, dy, dz) cells away from the cell of position
+				void insert_offset(const Math::Vector3D &position, int dx, int dy, int dz, int id);
+
+				/*
+				calls f(id) for every id in the 27 cells around position, until f returns false.
+				the ids are a superset of the ones within cell_size, the caller filters by distance.
+				*/
+				template<class F>
+				void for_each_nearby(const Math::Vector3D &position, F f) const {
+					int cx = (int) floor(position[0] * inverse_cell_size);
+					int cy = (int) floor(position[1] * inverse_cell_size);
+					int cz = (int) floor(position[2] * inverse_cell_size);
+					for (int x = cx - 1; x <= cx + 1; ++x)
+						for (int y = cy - 1; y <= cy + 1; ++y)
+							for (int z = cz - 1; z <= cz + 1; ++z) {
+								int slot = find_slot(cell_key(x, y, z));
+								for (int id = slots[slot].head; id != -1; id = next[id])
+									if (!f(id)) return;
+							}
+				}
+
+				//calls f(id) for every id in the cell of position, until f returns false
+				template<class F>
+				void for_each_in_cell(const Math::Vector3D &position, F f) const {
+					int slot = find_slot(cell_key((int) floor(position[0] * inverse_cell_size), (int) floor(position[1] * inverse_cell_size), (int) floor(position[2] * inverse_cell_size)));
+					for (int id = slots[slot].head; id != -1; id = next[id])
+						if (!f(id)) return;
+				}
+		};
+
+		/*
+		compressed sparse row adjacency over a point array.
+		the neighbours of point i are indices[offsets[i]] .. indices[offsets[i + 1] - 1], so all
+		the lists share one contiguous block.
+		*/
+		struct Adjacency {
+			std::vector<uint32_t> offsets;		//one entry per point, plus the total at the end
+			std::vector<uint32_t> indices;
+
+			inline int count(int i) const {return offsets[i + 1] - offsets[i];}
+			inline const uint32_t *begin(int i) const {return indices.data() + offsets[i];}
+			inline const uint32_t *end(int i) const {return indices.data() + offsets[i + 1];}
+		};
+
+		/*
+		for every point, finds all the other points within radius of it (inclusive).
+		points are binned into a grid with cells of size radius, so only the 27 cells
+		around each point are searched. every list is sorted by index.
+		*/
+		Adjacency radius_neighbours(const std::vector<Math::Vector3D> &points, float radius);
+
+		/*
+		writes the points that are neighbours of both a and b into out, sorted by index.
+		the sorted lists are intersected with a linear merge, or by galloping through the longer
+		list when one of them is much shorter.
+		*/
+		void common_neighbours(const Adjacency &adjacency, int a, int b, std::vector<uint32_t> &out);
+
+		/*
+		open addressing hash table from undirected edge keys to values.
+		clear() keeps the slots, so a table that is refilled every growth step stops allocating
+		once it has reached its largest size.
+		*/
+		template<class Value>
+		class EdgeTable {
+			private:
+				struct Slot {
+					uint64_t key;		//EMPTY for an empty slot
+					Value value;
+				};
+
+				static const uint64_t EMPTY = ~(uint64_t) 0;
+
+				std::vector<Slot> slots;		//the size is a power of 2
+				int used_slots;
+
+				int find_slot(uint64_t key) const {
+					uint64_t mask = slots.size() - 1;
+					uint64_t i = (key * 0x9E3779B97F4A7C15ull) >> 32 & mask;
+					while (slots[i].key != EMPTY && slots[i].key != key)
+						i = (i + 1) & mask;
+					return i;
+				}
+
+				void grow() {
+					std::vector<Slot> old;
+					old.swap(slots);
+					slots.assign(old.size() * 2, Slot{EMPTY, Value()});
+					for (const Slot &slot : old)
+						if (slot.key != EMPTY)
+							slots[find_slot(slot.key)] = slot;
+				}
+
+			public:
+				EdgeTable() : slots(64, Slot{EMPTY, Value()}), used_slots(0) {}
+
+				//the key of the undirected edge (a, b)
+				static inline uint64_t key(int a, int b) {
+					if (a > b) std::swap(a, b);
+					return ((uint64_t) a << 32) | (uint32_t) b;
+				}
+
+				//the value of key, or nullptr. the pointer is valid until the next insert
+				inline Value *find(uint64_t key) {
+					int slot = find_slot(key);
+					return slots[slot].key == EMPTY ? nullptr : &slots[slot].value;
+				}
+
+				inline const Value *find(uint64_t key) const {
+					int slot = find_slot(key);
+					return slots[slot].key == EMPTY ? nullptr : &slots[slot].value;
+				}
+
+				//sets the value of key, adding it if needed
+				void insert(uint64_t key, const Value &value) {
+					int slot = find_slot(key);
+					if (slots[slot].key == EMPTY) {
+						//keep the table at most half full
+						if ((used_slots + 1) * 2 > slots.size()) {
+							grow();
+							slot = find_slot(key);
+						}
+						used_slots++;
+						slots[slot].key = key;
+					}
+					slots[slot].value = value;
+				}
+
+				inline int size() const {return used_slots;}
+
+				void clear() {
+					for (Slot &slot : slots)
+						slot.key = EMPTY;
+					used_slots = 0;
+				}
+		};
+
+		//a run of point indices, iterable with a range for
+		struct IndexRange {
+			const uint32_t *first, *last;
+
+			inline const uint32_t *begin() const {return first;}
+			inline const uint32_t *end() const {return last;}
+			inline int size() const {return last - first;}
+		};
+
+		/*
+		caches the common neighbours of edges.
+		entries live for two generations: an edge used since the last call to next_generation()
+		stays cached, anything older is dropped. calling next_generation() once per surface growth
+		step keeps exactly the edges of the current frontier.
+		every generation keeps its lists in one flat array that is reused two generations later,
+		so a cache in steady state doesn't allocate.
+		*/
+		class EdgeNeighbourCache {
+			private:
+				struct Entry {
+					uint32_t offset, count;		//the list in the generation's indices
+				};
+
+				struct Generation {
+					EdgeTable<Entry> entries;
+					std::vector<uint32_t> indices;
+
+					void clear();
+				};
+
+				const Adjacency *adjacency;
+				Generation generations[2];
+				int current;
+				std::vector<uint32_t> scratch;
+
+			public:
+				EdgeNeighbourCache();
+
+				void init(const Adjacency &adjacency);
+
+				//the common neighbours of the edge (a, b), in either direction. valid until the next call
+				IndexRange get(int a, int b);
+
+				void next_generation();
+
+				void clear();
+		};
+
+		/*
+		edge -> triangles incidence of a triangle mesh that is kept manifold.
+		every undirected edge holds at most two triangles (with the vertex opposite to the edge in each),
+		so triangles that repeat an existing one or would put a third triangle on an edge are rejected.
+		vertices and triangles are referred to by index, all queries are O(1).
+		*/
+		class EdgeMesh {
+			private:
+				struct Edge {
+					int triangles[2];	//-1 for an empty side
+					int opposite[2];	//the third vertex of each triangle
+				};
+
+				EdgeTable<Edge> edges;
+
+				const Edge *find(int a, int b) const;
+
+			public:
+				//whether the triangle (a, b, c) would be accepted by add_triangle
+				bool can_add_triangle(int a, int b, int c) const;
+
+				//adds the triangle (a, b, c) as id, returns false (and adds nothing) when it is rejected
+				bool add_triangle(int a, int b, int c, int id);
+
+				//number of triangles (0 - 2) that use the edge (a, b)
+				int triangle_count(int a, int b) const;
+
+				//the triangle across the edge (a, b) from triangle id, or -1
+				int other_triangle(int a, int b, int id) const;
+
+				//an edge with two triangles is interior to the surface and can't take more
+				inline bool is_closed(int a, int b) const {return triangle_count(a, b) == 2;}
+
+				void clear();
+		};
+
+		/*
+		greedily thins points so no two kept points are closer than min_distance.
+		points are visited in order, and a point is kept only if no previously kept point is
+		within min_distance of it, so the first point of every cluster wins.
+		runs in expected linear time.
+		*/
+		std::vector<Math::Vector3D> thin_points(const std::vector<Math::Vector3D> &points, float min_distance);
+
+		/*
+		estimates the intrinsic dimension of a point cloud around the scale radius: about 1 for
+		points along curves, 2 on surfaces and 3 in volumes.
+		the points are subsampled so that consecutive sampled points are about radius / 4 apart
+		(from the mean spacing of consecutive points, so a longer trace gives a larger sample, not a
+		coarser one), then the pairs within radius and within 2 * radius are counted around up to
+		256 of them. the counts grow like radius^dimension, so the dimension is
+		log2(pairs(2 * radius) / pairs(radius)), clamped to [0, 3].
+		returns -1 (unknown) when there are less than 256 pairs within radius, too few to tell.
+		*/
+		float intrinsic_dimension(const std::vector<Math::Vector3D> &points, float radius);
+
+		/*
+		how much a point cloud with the given intrinsic dimension looks like a surface: 1 at
+		dimension 2, about 0.37 at 1.5 and 2.5, and under 0.02 for curves (1) and volumes (3).
+		0 for an unknown (negative) dimension.
+		*/
+		float surface_likelihood(float dimension);
+	}
+}
+
+#endif
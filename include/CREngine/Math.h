@@ -3,14 +3,24 @@
 
 #include <cmath>
 #include <string>
+#include <type_traits>
+
+//sse is used for Vector4A and Matrix4D unless CRENGINE_MATH_SCALAR is defined
+#if defined(__SSE__) && !defined(CRENGINE_MATH_SCALAR)
+#define CRENGINE_MATH_SSE
+#include <xmmintrin.h>
+#endif
 
 namespace CREngine {
 	namespace Math {
 		//definitions
 		class Vector2D;
 		class Vector3D;
+		class Vector4D;
+		class Vector4A;
 		class Matrix2D;
 		class Matrix3D;
+		class Quaternion;
 
 		class Vector2D {
 			public:
@@ -18,37 +28,35 @@ namespace CREngine {
 				float v[2];
 
 				//constructors
-				Vector2D();
-				Vector2D(float x, float y);
-				Vector2D(const Vector2D &vec);
+				constexpr Vector2D() : v{0.0f, 0.0f} {}
+				constexpr Vector2D(float x, float y) : v{x, y} {}
 
 				//setters and getters
 				inline void set(float x, float y) {v[0] = x; v[1] = y;}
-				inline float operator[](unsigned int i) const {return v[i];}
+				constexpr float operator[](unsigned int i) const {return v[i];}
 				inline float &operator[](unsigned int i) {return v[i];}
-				Vector2D operator=(const Vector2D &vec);
 
 				//overloaded operators
-				inline Vector2D operator+(const Vector2D &s) const {return Vector2D(v[0] + s.v[0], v[1] + s.v[1]);}
+				constexpr Vector2D operator+(const Vector2D &s) const {return Vector2D(v[0] + s.v[0], v[1] + s.v[1]);}
 				inline void operator+=(const Vector2D &s) {v[0] += s.v[0]; v[1] += s.v[1];}
 				
-				inline Vector2D operator-(const Vector2D &s) const {return Vector2D(v[0] - s.v[0], v[1] - s.v[1]);}
+				constexpr Vector2D operator-(const Vector2D &s) const {return Vector2D(v[0] - s.v[0], v[1] - s.v[1]);}
 				inline void operator-=(const Vector2D &s) {v[0] -= s.v[0]; v[1] -= s.v[1];}
 				
-				inline Vector2D operator*(float s) const {return Vector2D(v[0] * s, v[1] * s);}
+				constexpr Vector2D operator*(float s) const {return Vector2D(v[0] * s, v[1] * s);}
 				inline void operator*=(float s) {v[0] *= s; v[1] *= s;}
 				
-				inline Vector2D operator*(const Vector2D &s) const {return Vector2D(v[0] * s.v[0], v[1] * s.v[1]);}
+				constexpr Vector2D operator*(const Vector2D &s) const {return Vector2D(v[0] * s.v[0], v[1] * s.v[1]);}
 				inline void operator*=(const Vector2D &s) {v[0] *= s.v[0]; v[1] *= s.v[1];}
 
-				inline Vector2D operator/(float s) const {return Vector2D(v[0] / s, v[1] / s);}
+				constexpr Vector2D operator/(float s) const {return Vector2D(v[0] / s, v[1] / s);}
 				inline void operator/=(float s) {v[0] /= s; v[1] /= s;}
 				
-				inline Vector2D operator/(const Vector2D &s) const {return Vector2D(v[0] / s.v[0], v[1] / s.v[1]);}
+				constexpr Vector2D operator/(const Vector2D &s) const {return Vector2D(v[0] / s.v[0], v[1] / s.v[1]);}
 				inline void operator/=(const Vector2D &s) {v[0] /= s.v[0]; v[1] /= s.v[1];}
 
 				//products
-				inline float dot(const Vector2D &s) const {return v[0] * s[0] + v[1] * s[1];}
+				constexpr float dot(const Vector2D &s) const {return v[0] * s[0] + v[1] * s[1];}
 
 				//special operations
 				inline float length() const {return sqrt(v[0] * v[0] + v[1] * v[1]);}
@@ -70,42 +78,40 @@ namespace CREngine {
 				float v[3];
 				
 				//constructors
-				Vector3D();
-				Vector3D(float x, float y, float z);
-				Vector3D(const Vector3D &vec);
+				constexpr Vector3D() : v{0.0f, 0.0f, 0.0f} {}
+				constexpr Vector3D(float x, float y, float z) : v{x, y, z} {}
 				
 				//setters and getters
 				inline void set(float x, float y, float z) {v[0] = x; v[1] = y; v[2] = z;}
-				Vector3D operator=(const Vector3D &vec);
-				inline float operator[](unsigned int i) const {return v[i];}
+				constexpr float operator[](unsigned int i) const {return v[i];}
 				inline float &operator[](unsigned int i) {return v[i];}
 
 				//overloaded operators
-				inline Vector3D operator+(const Vector3D &s) const {return Vector3D(v[0] + s.v[0], v[1] + s.v[1], v[2] + s.v[2]);}
+				constexpr Vector3D operator+(const Vector3D &s) const {return Vector3D(v[0] + s.v[0], v[1] + s.v[1], v[2] + s.v[2]);}
 				inline void operator+=(const Vector3D &s) {v[0] += s.v[0]; v[1] += s.v[1]; v[2] += s.v[2];}
 				
-				inline Vector3D operator-(const Vector3D &s) const {return Vector3D(v[0] - s.v[0], v[1] - s.v[1], v[2] - s.v[2]);}
+				constexpr Vector3D operator-(const Vector3D &s) const {return Vector3D(v[0] - s.v[0], v[1] - s.v[1], v[2] - s.v[2]);}
 				inline void operator-=(const Vector3D &s) {v[0] -= s.v[0]; v[1] -= s.v[1]; v[2] -= s.v[2];}
 				
-				inline Vector3D operator*(float s) const {return Vector3D(v[0] * s, v[1] * s, v[2] * s);}
+				constexpr Vector3D operator*(float s) const {return Vector3D(v[0] * s, v[1] * s, v[2] * s);}
 				inline void operator*=(float s) {v[0] *= s; v[1] *= s; v[2] *= s;}
 				
-				inline Vector3D operator*(const Vector3D &s) const {return Vector3D(v[0] * s.v[0], v[1] * s.v[1], v[2] * s.v[2]);}
+				constexpr Vector3D operator*(const Vector3D &s) const {return Vector3D(v[0] * s.v[0], v[1] * s.v[1], v[2] * s.v[2]);}
 				inline void operator*=(const Vector3D &s) {v[0] *= s.v[0]; v[1] *= s.v[1]; v[2] *= s.v[2];}
 
-				inline Vector3D operator/(float s) const {return Vector3D(v[0] / s, v[1] / s, v[2] / s);}
+				constexpr Vector3D operator/(float s) const {return Vector3D(v[0] / s, v[1] / s, v[2] / s);}
 				inline void operator/=(float s) {v[0] /= s; v[1] /= s; v[2] /= s;}
 				
-				inline Vector3D operator/(const Vector3D &s) const {return Vector3D(v[0] / s.v[0], v[1] / s.v[1], v[2] / s.v[2]);}
+				constexpr Vector3D operator/(const Vector3D &s) const {return Vector3D(v[0] / s.v[0], v[1] / s.v[1], v[2] / s.v[2]);}
 				inline void operator/=(const Vector3D &s) {v[0] /= s.v[0]; v[1] /= s.v[1]; v[2] /= s.v[2];}
 
 				//products
-				inline float dot(const Vector3D &s) const {return v[0] * s[0] + v[1] * s[1] + v[2] * s[2];}
-				inline Vector3D cross(const Vector3D &s) const {return Vector3D(v[1] * s[2] - v[2] * s[1], v[2] * s[0] - v[0] * s[2], v[0] * s[1] - v[1] * s[0]);}
+				constexpr float dot(const Vector3D &s) const {return v[0] * s[0] + v[1] * s[1] + v[2] * s[2];}
+				constexpr Vector3D cross(const Vector3D &s) const {return Vector3D(v[1] * s[2] - v[2] * s[1], v[2] * s[0] - v[0] * s[2], v[0] * s[1] - v[1] * s[0]);}
 
 				//special operations
 				inline float length() const {return sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);}
-				inline Vector3D normalize() const {float l = length(); return Vector3D(v[0] / l, v[1] / l, v[2] / l);}
+				inline Vector3D normalize() const {float s = 1.0f / length(); return Vector3D(v[0] * s, v[1] * s, v[2] * s);}
 				inline float distance_from(const Vector3D &v) const { return (*this - v).length(); }
 
 				inline float angle_cos(const Vector3D &v) const { return (this->dot(v))/ (length() * v.length()); }
@@ -120,41 +126,39 @@ namespace CREngine {
 			float v[4];
 
 			//constructors
-			Vector4D();
-			Vector4D(float x, float y, float z, float w);
-			Vector4D(const Vector4D &vec);
+			constexpr Vector4D() : v{0.0f, 0.0f, 0.0f, 0.0f} {}
+			constexpr Vector4D(float x, float y, float z, float w) : v{x, y, z, w} {}
 
 			//setters and getters
 			inline void set(float x, float y, float z, float w) {v[0] = x; v[1] = y; v[2] = z; v[3] = w;}
-			Vector4D operator=(const Vector4D &vec);
-			inline float operator[](unsigned int i) const {return v[i];}
+			constexpr float operator[](unsigned int i) const {return v[i];}
 			inline float &operator[](unsigned int i) {return v[i];}
 
 			//overloaded operators
-			inline Vector4D operator+(const Vector4D &s) const {return Vector4D(v[0] + s.v[0], v[1] + s.v[1], v[2] + s.v[2], v[3] + s.v[3]);}
+			constexpr Vector4D operator+(const Vector4D &s) const {return Vector4D(v[0] + s.v[0], v[1] + s.v[1], v[2] + s.v[2], v[3] + s.v[3]);}
 			inline void operator+=(const Vector4D &s) {v[0] += s.v[0]; v[1] += s.v[1]; v[2] += s.v[2]; v[3] += s.v[3];}
 			
-			inline Vector4D operator-(const Vector4D &s) const {return Vector4D(v[0] - s.v[0], v[1] - s.v[1], v[2] - s.v[2], v[3] - s.v[3]);}
+			constexpr Vector4D operator-(const Vector4D &s) const {return Vector4D(v[0] - s.v[0], v[1] - s.v[1], v[2] - s.v[2], v[3] - s.v[3]);}
 			inline void operator-=(const Vector4D &s) {v[0] -= s.v[0]; v[1] -= s.v[1]; v[2] -= s.v[2]; v[3] -= s.v[3];}
 			
-			inline Vector4D operator*(float s) const {return Vector4D(v[0] * s, v[1] * s, v[2] * s, v[3] * s);}
+			constexpr Vector4D operator*(float s) const {return Vector4D(v[0] * s, v[1] * s, v[2] * s, v[3] * s);}
 			inline void operator*=(float s) {v[0] *= s; v[1] *= s; v[2] *= s; v[3] *= s;}
 			
-			inline Vector4D operator*(const Vector4D &s) const {return Vector4D(v[0] * s.v[0], v[1] * s.v[1], v[2] * s.v[2], v[3] * s.v[3]);}
+			constexpr Vector4D operator*(const Vector4D &s) const {return Vector4D(v[0] * s.v[0], v[1] * s.v[1], v[2] * s.v[2], v[3] * s.v[3]);}
 			inline void operator*=(const Vector4D &s) {v[0] *= s.v[0]; v[1] *= s.v[1]; v[2] *= s.v[2]; v[3] *= s.v[3];}
 
-			inline Vector4D operator/(float s) const {return Vector4D(v[0] / s, v[1] / s, v[2] / s, v[3] / s);}
+			constexpr Vector4D operator/(float s) const {return Vector4D(v[0] / s, v[1] / s, v[2] / s, v[3] / s);}
 			inline void operator/=(float s) {v[0] /= s; v[1] /= s; v[2] /= s; v[3] /= s;}
 			
-			inline Vector4D operator/(const Vector4D &s) const {return Vector4D(v[0] / s.v[0], v[1] / s.v[1], v[2] / s.v[2], v[3] / s.v[3]);}
+			constexpr Vector4D operator/(const Vector4D &s) const {return Vector4D(v[0] / s.v[0], v[1] / s.v[1], v[2] / s.v[2], v[3] / s.v[3]);}
 			inline void operator/=(const Vector4D &s) {v[0] /= s.v[0]; v[1] /= s.v[1]; v[2] /= s.v[2]; v[3] /= s.v[3];}
 
 			//products
-			inline float dot(const Vector4D &s) const {return v[0] * s[0] + v[1] * s[1] + v[2] * s[2] + v[3] * s[3];}
+			constexpr float dot(const Vector4D &s) const {return v[0] * s[0] + v[1] * s[1] + v[2] * s[2] + v[3] * s[3];}
 			
 			//special operations
 			inline float length() const {return sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3]);}
-			inline Vector4D normalize() {float l = length(); return Vector4D(v[0] / l, v[1] / l, v[2] / l, v[3] / l);}
+			inline Vector4D normalize() const {float s = 1.0f / length(); return Vector4D(v[0] * s, v[1] * s, v[2] * s, v[3] * s);}
 			inline float distance_from(const Vector4D &v) const { return (*this - v).length(); }
 
 			//debug
@@ -162,18 +166,96 @@ namespace CREngine {
 			void print();
 		};
 
+		/*
+		4 floats aligned to 16 bytes, so every operation is a single sse instruction on one register.
+		meant for hot loops: convert in (w = 1 for points, 0 for directions), work, convert out.
+		without sse the same operations run on plain floats.
+		*/
+		class alignas(16) Vector4A {
+		public:
+			float v[4];
+
+			//constructors
+			constexpr Vector4A() : v{0.0f, 0.0f, 0.0f, 0.0f} {}
+			constexpr Vector4A(float x, float y, float z, float w) : v{x, y, z, w} {}
+#ifdef CRENGINE_MATH_SSE
+			//filled as one register, element by element stores would stall the load that follows them
+			inline explicit Vector4A(const Vector4D &vec) {_mm_store_ps(v, _mm_loadu_ps(vec.v));}
+			inline explicit Vector4A(const Vector3D &vec, float w = 0.0f) {_mm_store_ps(v, _mm_set_ps(w, vec[2], vec[1], vec[0]));}
+#else
+			constexpr explicit Vector4A(const Vector4D &vec) : v{vec[0], vec[1], vec[2], vec[3]} {}
+			constexpr explicit Vector4A(const Vector3D &vec, float w = 0.0f) : v{vec[0], vec[1], vec[2], w} {}
+#endif
+
+			//setters and getters
+			constexpr float operator[](unsigned int i) const {return v[i];}
+			inline float &operator[](unsigned int i) {return v[i];}
+			constexpr Vector3D xyz() const {return Vector3D(v[0], v[1], v[2]);}
+			constexpr Vector4D xyzw() const {return Vector4D(v[0], v[1], v[2], v[3]);}
+
+#ifdef CRENGINE_MATH_SSE
+			inline __m128 load() const {return _mm_load_ps(v);}
+			static inline Vector4A store(__m128 m) {Vector4A out; _mm_store_ps(out.v, m); return out;}
+
+			//overloaded operators
+			inline Vector4A operator+(const Vector4A &s) const {return store(_mm_add_ps(load(), s.load()));}
+			inline Vector4A operator-(const Vector4A &s) const {return store(_mm_sub_ps(load(), s.load()));}
+			inline Vector4A operator*(const Vector4A &s) const {return store(_mm_mul_ps(load(), s.load()));}
+			inline Vector4A operator*(float s) const {return store(_mm_mul_ps(load(), _mm_set1_ps(s)));}
+
+			//products, the sum is broadcast to all lanes
+			inline __m128 dot4(const Vector4A &s) const {
+				__m128 m = _mm_mul_ps(load(), s.load());
+				m = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+				return _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+			}
+			inline float dot(const Vector4A &s) const {return _mm_cvtss_f32(dot4(s));}
+
+			//special operations
+			inline float length() const {return _mm_cvtss_f32(_mm_sqrt_ss(dot4(*this)));}
+
+			/*
+			scales by the approximate reciprocal square root (12 bits), refined with one newton step,
+			which is within a few ulp of dividing by length() at a fraction of the cost
+			*/
+			inline Vector4A normalize() const {
+				__m128 d = dot4(*this);
+				__m128 r = _mm_rsqrt_ps(d);
+				r = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), r), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(d, r), r)));
+				return store(_mm_mul_ps(load(), r));
+			}
+#else
+			//overloaded operators
+			inline Vector4A operator+(const Vector4A &s) const {return Vector4A(v[0] + s.v[0], v[1] + s.v[1], v[2] + s.v[2], v[3] + s.v[3]);}
+			inline Vector4A operator-(const Vector4A &s) const {return Vector4A(v[0] - s.v[0], v[1] - s.v[1], v[2] - s.v[2], v[3] - s.v[3]);}
+			inline Vector4A operator*(const Vector4A &s) const {return Vector4A(v[0] * s.v[0], v[1] * s.v[1], v[2] * s.v[2], v[3] * s.v[3]);}
+			inline Vector4A operator*(float s) const {return Vector4A(v[0] * s, v[1] * s, v[2] * s, v[3] * s);}
+
+			//products
+			inline float dot(const Vector4A &s) const {return v[0] * s.v[0] + v[1] * s.v[1] + v[2] * s.v[2] + v[3] * s.v[3];}
+
+			//special operations
+			inline float length() const {return sqrt(dot(*this));}
+			inline Vector4A normalize() const {return *this * (1.0f / length());}
+#endif
+			inline void operator+=(const Vector4A &s) {*this = *this + s;}
+			inline void operator-=(const Vector4A &s) {*this = *this - s;}
+			inline void operator*=(float s) {*this = *this * s;}
+
+			inline float distance_from(const Vector4A &s) const {return (*this - s).length();}
+		};
+
 		class Matrix2D {
 		public:
 			Vector2D rows[2];
 
 			//constructors
-			Matrix2D(float a, float b, float c, float d);
-			Matrix2D(const Vector2D &row_a, const Vector2D &row_b);
+			constexpr Matrix2D(float a, float b, float c, float d) : rows{Vector2D(a, b), Vector2D(c, d)} {}
+			constexpr Matrix2D(const Vector2D &row_a, const Vector2D &row_b) : rows{row_a, row_b} {}
 
 			//setters and getters
 			//void set(float x, float y, float z, float w) {v[0] = x; v[1] = y; v[2] = z; v[3] = w;}
-			Matrix2D operator=(const Matrix2D &mat);
-			inline const Vector2D &operator[](unsigned int i) const {return rows[i];}
+			constexpr const Vector2D &operator[](unsigned int i) const {return rows[i];}
 			inline Vector2D &operator[](unsigned int i) {return rows[i];}
 
 			//overloaded operators
@@ -188,18 +270,27 @@ namespace CREngine {
 			static Matrix2D rotation(float theta);
 		};
 
+		/*
+		3x3 matrix stored column-major, so columns[0].v[0] is the first of 9 contiguous floats
+		that can be uploaded with glUniformMatrix3fv without transposing.
+		constructors and operator[] still work with rows.
+		*/
 		class Matrix3D {
 		public:
-			Vector3D rows[4];
+			Vector3D columns[3];
 
-			Matrix3D();
+			Matrix3D() = default;
 
-			Matrix3D(const Vector3D &row_a, const Vector3D &row_b, const Vector3D &row_c);
+			constexpr Matrix3D(const Vector3D &row_a, const Vector3D &row_b, const Vector3D &row_c) :
+				columns{Vector3D(row_a[0], row_b[0], row_c[0]), Vector3D(row_a[1], row_b[1], row_c[1]), Vector3D(row_a[2], row_b[2], row_c[2])} {}
 
-			//void set(float x, float y, float z, float w) {v[0] = x; v[1] = y; v[2] = z; v[3] = w;}
+			//setters and getters
+			constexpr float operator()(unsigned int row, unsigned int column) const {return columns[column][row];}
+			inline float &operator()(unsigned int row, unsigned int column) {return columns[column][row];}
+			constexpr Vector3D operator[](unsigned int i) const {return Vector3D(columns[0][i], columns[1][i], columns[2][i]);}
 
-			Vector3D operator[](unsigned int i) const {return rows[i];}
-			Vector3D &operator[](unsigned int i) {return rows[i];}
+			//the 9 elements, column by column
+			inline const float *data() const {return &columns[0].v[0];}
 
 			//matrix - vector operations
 			Matrix3D operator*(float s) const;
@@ -213,30 +304,50 @@ namespace CREngine {
 			static Matrix3D rotation(const Vector3D &axis);
 		};
 
+		/*
+		4x4 matrix stored column-major, the layout of a mat4 in glUniformMatrix4fv (without transposing)
+		and in a std140 uniform block. constructors and operator[] still work with rows.
+		*/
 		class Matrix4D {
 		public:
-			Vector4D rows[4];
+			Vector4D columns[4];
 
-			Matrix4D();
+			Matrix4D() = default;
 
-			Matrix4D(const Vector4D &row_a, const Vector4D &row_b, const Vector4D &row_c, const Vector4D &row_d);
+			constexpr Matrix4D(const Vector4D &row_a, const Vector4D &row_b, const Vector4D &row_c, const Vector4D &row_d) :
+				columns{
+					Vector4D(row_a[0], row_b[0], row_c[0], row_d[0]),
+					Vector4D(row_a[1], row_b[1], row_c[1], row_d[1]),
+					Vector4D(row_a[2], row_b[2], row_c[2], row_d[2]),
+					Vector4D(row_a[3], row_b[3], row_c[3], row_d[3])
+				} {}
 
-			//void set(float x, float y, float z, float w) {v[0] = x; v[1] = y; v[2] = z; v[3] = w;}
+			//setters and getters
+			constexpr float operator()(unsigned int row, unsigned int column) const {return columns[column][row];}
+			inline float &operator()(unsigned int row, unsigned int column) {return columns[column][row];}
+			constexpr Vector4D operator[](unsigned int i) const {return Vector4D(columns[0][i], columns[1][i], columns[2][i], columns[3][i]);}
 
-			inline void operator=(const Matrix4D &mat) {
-				rows[0] = mat.rows[0];
-				rows[1] = mat.rows[1];
-				rows[2] = mat.rows[2];
-				rows[3] = mat.rows[3];
-			}
-			
-			Vector4D operator[](unsigned int i) const {return rows[i];}
-			Vector4D &operator[](unsigned int i) {return rows[i];}
+			//the 16 elements, column by column
+			inline const float *data() const {return &columns[0].v[0];}
 
 			//matrix - vector operations
-			Vector4D operator*(const Vector4D &vec);
+			Vector4D operator*(const Vector4D &vec) const;
+
+			//the aligned version, inlined for loops over many vectors
+			inline Vector4A operator*(const Vector4A &vec) const {
+#ifdef CRENGINE_MATH_SSE
+				__m128 m = vec.load();
+				__m128 out = _mm_mul_ps(_mm_loadu_ps(columns[0].v), _mm_shuffle_ps(m, m, _MM_SHUFFLE(0, 0, 0, 0)));
+				out = _mm_add_ps(out, _mm_mul_ps(_mm_loadu_ps(columns[1].v), _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1))));
+				out = _mm_add_ps(out, _mm_mul_ps(_mm_loadu_ps(columns[2].v), _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2))));
+				out = _mm_add_ps(out, _mm_mul_ps(_mm_loadu_ps(columns[3].v), _mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 3, 3, 3))));
+				return Vector4A::store(out);
+#else
+				return Vector4A(columns[0] * vec[0] + columns[1] * vec[1] + columns[2] * vec[2] + columns[3] * vec[3]);
+#endif
+			}
 
-			Matrix4D operator*(const Matrix4D &mat);
+			Matrix4D operator*(const Matrix4D &mat) const;
 
 			//static creators
 			static Matrix4D identity();
@@ -244,6 +355,111 @@ namespace CREngine {
 			static Matrix4D view(const Vector3D &right, const Vector3D &up, const Vector3D &forward);
 			static Matrix4D orthographic_projection(const Vector2D &size, float n, float f);
 		};
+
+		/*
+		unit quaternion w + xi + yj + zk representing a rotation.
+		composing two rotations is 16 multiplies instead of the 27 of a 3x3 product, and a rotation
+		around a fixed axis is advanced by turning its (cos, sin) of the half angle.
+		*/
+		class Quaternion {
+		public:
+			float w, x, y, z;
+
+			//constructors, the default is no rotation
+			constexpr Quaternion() : w(1.0f), x(0.0f), y(0.0f), z(0.0f) {}
+			constexpr Quaternion(float w, float x, float y, float z) : w(w), x(x), y(y), z(z) {}
+
+			//rotation around a unit axis by the angle whose half has the given cosine and sine
+			static constexpr Quaternion half_angle(const Vector3D &unit_axis, float half_cos, float half_sin) {
+				return Quaternion(half_cos, unit_axis[0] * half_sin, unit_axis[1] * half_sin, unit_axis[2] * half_sin);
+			}
+
+			//overloaded operators, a * b rotates by b first and then by a
+			constexpr Quaternion operator*(const Quaternion &q) const {
+				return Quaternion(
+					w * q.w - x * q.x - y * q.y - z * q.z,
+					w * q.x + x * q.w + y * q.z - z * q.y,
+					w * q.y - x * q.z + y * q.w + z * q.x,
+					w * q.z + x * q.y - y * q.x + z * q.w
+				);
+			}
+
+			constexpr Quaternion conjugate() const {return Quaternion(w, -x, -y, -z);}
+
+			//special operations
+			inline float length() const {return sqrt(w * w + x * x + y * y + z * z);}
+			inline Quaternion normalize() const {float s = 1.0f / length(); return Quaternion(w * s, x * s, y * s, z * s);}
+
+			//the vector rotated, v + 2w (u x v) + 2u x (u x v) with u = (x, y, z)
+			inline Vector3D rotate(const Vector3D &v) const {
+				Vector3D u(x, y, z);
+				Vector3D t = u.cross(v) * 2.0f;
+				return v + t * w + u.cross(t);
+			}
+
+			//the rotated x axis, the first column of the rotation matrix
+			constexpr Vector3D x_axis() const {return Vector3D(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y));}
+
+			Matrix3D to_matrix() const;
+
+			//static creators
+			static Quaternion axis_angle(const Vector3D &axis, float angle);
+
+			//like Matrix3D::rotation, the magnitude of axis is the angle
+			static Quaternion rotation(const Vector3D &axis);
+		};
+
+		/*
+		all the types are plain arrays of floats: copies are memcpy, and arrays of them can be
+		handed to gl buffers, files or other processes as raw memory.
+		*/
+		#define CRENGINE_MATH_CHECK_LAYOUT(T, floats) \
+			static_assert(std::is_trivially_copyable<T>::value, #T " has to be trivially copyable"); \
+			static_assert(std::is_standard_layout<T>::value, #T " has to be standard layout"); \
+			static_assert(sizeof(T) == (floats) * sizeof(float), #T " has to be " #floats " packed floats"); \
+			static_assert(alignof(T) == alignof(float), #T " has to be aligned like a float")
+
+		CRENGINE_MATH_CHECK_LAYOUT(Vector2D, 2);
+		CRENGINE_MATH_CHECK_LAYOUT(Vector3D, 3);
+		CRENGINE_MATH_CHECK_LAYOUT(Vector4D, 4);
+		CRENGINE_MATH_CHECK_LAYOUT(Matrix2D, 4);
+		CRENGINE_MATH_CHECK_LAYOUT(Matrix3D, 9);
+		CRENGINE_MATH_CHECK_LAYOUT(Matrix4D, 16);
+		CRENGINE_MATH_CHECK_LAYOUT(Quaternion, 4);
+
+		#undef CRENGINE_MATH_CHECK_LAYOUT
+
+		static_assert(std::is_trivially_copyable<Vector4A>::value && std::is_standard_layout<Vector4A>::value, "Vector4A has to be plain data");
+		static_assert(sizeof(Vector4A) == 16 && alignof(Vector4A) == 16, "Vector4A has to fill exactly one sse register");
+
+		/*
+		kernels over arrays of 'count' points, given either as an array of Vector3D or as separate
+		x, y, z arrays. they take 4 points at a time with sse intrinsics (and the remaining points
+		one by one, which is all of them with CRENGINE_MATH_SCALAR), and inputs of more than a few
+		ten thousand points are split into contiguous ranges over up to 'threads' threads (0 = one
+		per hardware thread).
+		*/
+
+		//out[i] = mat * points[i], as a point (w = 1, the resulting w is dropped). out may be points
+		void transform_points(const Matrix4D &mat, const Vector3D *points, int count, Vector3D *out, int threads = 1);
+		void transform_points(const Matrix3D &mat, const Vector3D *points, int count, Vector3D *out, int threads = 1);
+		void transform_points(const Matrix4D &mat, const float *x, const float *y, const float *z, int count, float *out_x, float *out_y, float *out_z, int threads = 1);
+
+		//out[i] = the distance between point and points[i]
+		void distances_to(const Vector3D &point, const Vector3D *points, int count, float *out, int threads = 1);
+		void distances_to(const Vector3D &point, const float *x, const float *y, const float *z, int count, float *out, int threads = 1);
+
+		//number of points within radius of point (inclusive)
+		int count_within_radius(const Vector3D &point, const Vector3D *points, int count, float radius, int threads = 1);
+		int count_within_radius(const Vector3D &point, const float *x, const float *y, const float *z, int count, float radius, int threads = 1);
+
+		//index of the point farthest from point (the first one on ties), skipping NaN distances. 0 when every distance is NaN, -1 when count is 0
+		int argmax_distance(const Vector3D &point, const Vector3D *points, int count, int threads = 1);
+		int argmax_distance(const Vector3D &point, const float *x, const float *y, const float *z, int count, int threads = 1);
+
+		//the mean of the points, accumulated in double precision. (0, 0, 0) when count is 0
+		Vector3D centroid(const Vector3D *points, int count, int threads = 1);
+		Vector3D centroid(const float *x, const float *y, const float *z, int count, int threads = 1);
 	}
 }
 
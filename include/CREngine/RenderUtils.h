@@ -60,12 +60,69 @@ namespace CREngine {
 			const Glyph *get_glyph(char c) const;
 		};
 
+		/*
+		'count' groups of 'components' floats, 'stride' floats apart from each other.
+		lets a batcher read vertex data where it already is, e.g. the positions in a std::vector<Math::Vector3D>.
+		*/
+		struct StridedView {
+			const float *data;
+			unsigned int count, components, stride;
+
+			StridedView(const float *data, unsigned int count, unsigned int components, unsigned int stride) : data(data), count(count), components(components), stride(stride) {}
+
+			StridedView(const std::vector<Math::Vector3D> &vectors) : data((const float *) vectors.data()), count(vectors.size()), components(3), stride(sizeof(Math::Vector3D) / sizeof(float)) {}
+		};
+
+		/*
+		one vertex attribute: 'size' components of 'type'.
+		integer types are mapped to [0, 1] ([-1, 1] for signed types) when 'normalized' is set.
+		supported types are GL_FLOAT, GL_HALF_FLOAT, GL_BYTE, GL_UNSIGNED_BYTE and GL_INT_2_10_10_10_REV,
+		which packs 4 components (10 bits for x, y, z and 2 for w, size has to be 4) in 4 bytes.
+		every attribute is padded to 4 bytes.
+		*/
+		struct Layout {
+			int size;
+			GLenum type;
+			bool normalized;
+
+			Layout(int size) : size(size), type(GL_FLOAT), normalized(false) {}
+
+			Layout(int size, GLenum type, bool normalized = false) : size(size), type(type), normalized(normalized) {}
+
+			//the size of the attribute in a vertex, in bytes
+			unsigned int bytes() const;
+		};
+
+		/*
+		collects vertices and draws them with one call.
+		by default the vertices are collected in a cpu side buffer and sent with update(). a batcher
+		created with init_streaming() has no cpu side buffer: it writes straight into the mapped VBO,
+		and every update() publishes a new content that replaces the previous one.
+		the float functions (add_data, reserve, ...) write the vertices as they are, so they are meant
+		for GL_FLOAT layouts. add_vertices() converts to any layout.
+		*/
 		class Batcher : public Utils::Nameable {
 			protected:
+				static const int STREAM_REGIONS = 3;	//regions of a persistently mapped VBO, used in turns
+
 				unsigned int max_size, current_size;	//in bytes
-				unsigned int layouts_total_size;
-				std::shared_ptr<float> buffer;
+				unsigned int vertex_size;				//in bytes
+				std::vector<Layout> layouts;
+				unsigned int gpu_size;					//in bytes, allocated for VBO
+				std::vector<unsigned char> buffer;
 				GLuint VAO, VBO;
+
+				//streaming
+				bool streaming, persistent;		//persistent: mapped once with glBufferStorage, otherwise orphaned every update
+				bool writing;					//a region is being written since the last update
+				unsigned char *mapped;			//the persistent mapping, or the mapping of the current update
+				int region, draw_region;
+				unsigned int draw_size;			//in bytes, published by the last update
+				mutable GLsync fences[STREAM_REGIONS];	//set after the draws that read each region
+
+				void init_vertex_array(const std::vector<Layout> &layouts);
+				void begin_write();
+				unsigned char *reserve_bytes(unsigned int size);
 				
 			public:
 				GLenum mode;
@@ -76,9 +133,41 @@ namespace CREngine {
 				
 				~Batcher();
 
+				void init(unsigned int max_number_of_elements, const std::vector<Layout> &layouts);
+
+				//all the layouts are GL_FLOAT, with the given sizes
 				void init(unsigned int max_number_of_elements, const std::vector<int> &layouts_sizes);
+
+				/*
+				like init(), in streaming mode.
+				with GL_ARB_buffer_storage the VBO holds a few regions that stay mapped. each update writes
+				the next region, after waiting on the fence of the last draw that read it, so the cpu never
+				stalls on a buffer the gpu is still drawing. without it the VBO is orphaned and mapped again
+				on every update (GL 3.3).
+				*/
+				void init_streaming(unsigned int max_number_of_elements, const std::vector<Layout> &layouts);
+
+				void init_streaming(unsigned int max_number_of_elements, const std::vector<int> &layouts_sizes);
+
+				/*
+				room for data_length floats after the current data, to write into directly (in streaming
+				mode it is mapped gpu memory). the written floats are added with commit().
+				returns nullptr, and logs an error, when they don't fit in max_number_of_elements; add_data()
+				and add_vertices() then add nothing.
+				*/
+				float *reserve(unsigned int data_length);
+
+				void commit(unsigned int data_length);
 				
-				void add_data(float *data, unsigned int data_length);
+				void add_data(const float *data, unsigned int data_length);
+
+				/*
+				adds a vertex for every group in view. a vertex is made of the group's floats followed by
+				rest (the same for every vertex, or zeros), one float per component of every layout, and
+				is converted to the layouts' types. floats of the group past the layouts' components are
+				ignored. the layouts can have up to 64 components.
+				*/
+				void add_vertices(const StridedView &view, const float *rest = nullptr);
 
 				void update();
 
@@ -87,10 +176,64 @@ namespace CREngine {
 				virtual void render() const;
 		};
 
+		/*
+		a batcher that draws with glDrawElements.
+		the vertices are written with the Batcher functions, and every group of indices (3 for
+		GL_TRIANGLES) in the element buffer makes a primitive, so vertices shared by many
+		primitives are stored and transformed once.
+		*/
+		class IndexedBatcher : public Batcher {
+			protected:
+				GLuint EBO;
+				unsigned int index_count;
+				unsigned int index_gpu_size;	//in bytes, allocated for EBO
+
+			public:
+				IndexedBatcher();
+
+				IndexedBatcher(const std::string &name);
+
+				~IndexedBatcher();
+
+				void init(unsigned int max_number_of_elements, unsigned int max_number_of_indices, const std::vector<Layout> &layouts);
+
+				//uploads indices right after the current ones, growing the element buffer when it is full
+				void append_indices(const GLuint *indices, unsigned int count);
+
+				void clear_indices();
+
+				virtual void render() const;
+		};
+
+		/*
+		a uniform buffer attached to a binding point. every program that binds its block to the same
+		point (Shader::bind_block) reads it, so data shared by many programs is uploaded once.
+		the data has to follow the block's layout (std140).
+		*/
+		class UniformBuffer : public Utils::Nameable {
+			private:
+				GLuint UBO;
+				unsigned int size;		//in bytes
+
+			public:
+				UniformBuffer(const std::string &name);
+
+				~UniformBuffer();
+
+				void init(GLuint binding, unsigned int size);
+
+				void update(const void *data, unsigned int size, unsigned int offset = 0);
+		};
+
+		/*
+		a shader program.
+		the uniforms are discovered from the linked program. get_uniform_location() is a lookup by
+		name, callers that bind a uniform often should keep its location and use the GLint overloads.
+		*/
 		class Shader : public Utils::Nameable {
 			private:
 				GLuint programID;
-				std::map<std::string, GLint> uniforms;
+				std::map<std::string, GLint> uniforms;		//uniforms outside of blocks
 
 			public:
 				Shader(const std::string &name);
@@ -101,14 +244,23 @@ namespace CREngine {
 				void init_from_text(const std::string &vertex_shader, const std::string &fragment_shader);
 				void init_from_file(const std::string &vertex_shader_path, const std::string &fragment_shader_path);
 				
+				//-1 if the program has no such uniform
 				GLint get_uniform_location(const std::string &name);
 
+				//attaches the uniform block to a binding point, does nothing if the program has no such block
+				void bind_block(const std::string &name, GLuint binding);
+
 				void bind_vec(const std::string &name, const Math::Vector2D &v);
 				void bind_vec(const std::string &name, const Math::Vector3D &v);
+				void bind_vec(GLint location, const Math::Vector2D &v);
+				void bind_vec(GLint location, const Math::Vector3D &v);
 				
 				void bind_mat(const std::string &name, const Math::Matrix2D &mat);
 				void bind_mat(const std::string &name, const Math::Matrix3D &mat);
 				void bind_mat(const std::string &name, const Math::Matrix4D &mat);
+				void bind_mat(GLint location, const Math::Matrix2D &mat);
+				void bind_mat(GLint location, const Math::Matrix3D &mat);
+				void bind_mat(GLint location, const Math::Matrix4D &mat);
 
 				void use();
 		};
@@ -0,0 +1,67 @@
+#ifndef CRENGINE_PUBLIC_HEADER_SPIROGRAPH
+#define CRENGINE_PUBLIC_HEADER_SPIROGRAPH
+
+#include <CREngine/Math.h>
+
+#include <tuple>
+#include <vector>
+
+namespace CREngine {
+	namespace Spirograph {
+		//one tuple per handle: axis (magnitude = anglular frequency), length
+		typedef std::vector<std::tuple<Math::Vector3D, float>> Structure;
+
+		/*
+		the kernel used to trace a spirograph.
+		SIMD rotates blocks of samples held as separate x, y, z arrays with SSE/AVX (picked at
+		compile time, -mavx enables 8 lanes), and falls back to plain floats when neither is available.
+		*/
+		enum Backend {SCALAR, SIMD};
+
+		/*
+		the position of the spirograph's head at the given time.
+		builds every handle rotation from scratch, mainly useful as a reference.
+		*/
+		Math::Vector3D evaluate(const Structure &structure, float time);
+
+		//evaluate() with quaternions in place of the rotation matrices
+		Math::Vector3D evaluate_quaternion(const Structure &structure, float time);
+
+		/*
+		samples the spirograph at t0, t0 + step_delta, ..., t0 + (steps - 1) * step_delta.
+		each handle's rotation is advanced by composing it with a precomputed per-step rotation,
+		and is rebuilt exactly every few hundred samples so the drift stays bounded.
+		the samples stay within 1e-5 of the total handle length from the exact curve. evaluate()
+		works with float angles, so for large times (t > 1000) it is the less accurate of the two.
+		*/
+		std::vector<Math::Vector3D> trace(const Structure &structure, float t0, float step_delta, int steps, Backend backend = SCALAR);
+
+		/*
+		same samples as trace(), computed by splitting the time range into chunks that are traced
+		on up to 'threads' worker threads (0 = one per hardware thread).
+		every sample depends only on its time, so the output is identical to trace().
+		*/
+		std::vector<Math::Vector3D> trace_parallel(const Structure &structure, float t0, float step_delta, int steps, int threads = 0, Backend backend = SCALAR);
+
+		/*
+		the period of the spirograph: the smallest time T after which every handle has turned a whole
+		number of times, so the curve retraces itself from then on (and a trace longer than T only
+		repeats samples of the curve).
+		float speeds are never exactly rational, so the curve is allowed to drift a little every
+		period, as long as the whole curve up to max_period stays within tolerance (in the units of
+		the handle lengths) of its first period. candidates are the whole turns of the slowest handle,
+		so the search is linear in max_period.
+		returns 0 when no handle turns (the curve is a single point), and -1 when there is no period
+		up to max_period.
+		*/
+		float period(const Structure &structure, float max_period, float tolerance = 0.01f);
+
+		/*
+		evaluates the spirograph at 'count' arbitrary times using the simd kernel, and writes the
+		head positions into the separate x, y, z arrays.
+		*/
+		void evaluate_batch(const Structure &structure, const float *times, int count, float *x, float *y, float *z);
+	}
+}
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef CRENGINE_PUBLIC_HEADER_SURFACE_PIPELINE
+#define CRENGINE_PUBLIC_HEADER_SURFACE_PIPELINE
+
+#include <CREngine/Math.h>
+#include <CREngine/Spirograph.h>
+#include <CREngine/Geometry.h>
+#include <CREngine/Utils.h>
+
+#include <vector>
+
+namespace CREngine {
+	/*
+	the spirograph -> surface pipeline: generate a trace, trim it to a point cloud, find the nearby
+	points and grow a triangle mesh over them.
+	nothing here touches SDL or GL, the application only uploads the results, so the pipeline can run
+	(and be benchmarked) without a display.
+	every instance owns its parameters, buffers and mesh, and there is no shared state, so separate
+	instances can run on separate threads.
+	*/
+	class SurfacePipeline {
+		public:
+			struct Parameters {
+				Spirograph::Structure structure;	//axis (magnitude = anglular frequency), length
+				Spirograph::Backend backend;
+				int steps;
+				float step_delta;
+				float start_time;					//the time of the first sample
+				float point_r;						//minimum spacing between elements
+				float angle_cos_limit;				//filtering the direction of the tirangle surfaces
+				int threads;						//trace threads, 0 = one per hardware thread
+				float min_surface_likelihood;		//run() skips the surface below this, 0 never skips
+				float period_tolerance;				//for Spirograph::period, 0 never caps the trace
+
+				Parameters();
+			};
+
+			class Vertex : public Math::Vector3D {
+				private:
+					int vertex_index;
+
+				public:
+					Vertex(const Math::Vector3D &position, int index) : Vector3D(position), vertex_index(index) {}
+
+					//the position in vertices()
+					inline int index() const {return vertex_index;}
+			};
+
+			class Triangle {
+				public:
+					Vertex *v[3];
+					Triangle(Vertex *a, Vertex *b, Vertex *c) : v{a, b, c} {}
+
+					Math::Vector3D normal() const {
+						return (*v[1] - *v[0]).cross(*v[2] - *v[1]).normalize();
+					}
+
+					Math::Vector3D center() const {
+						return (*v[0] + *v[1] + *v[2]) * (1.0f / 3.0f);
+					}
+
+					void flip_vertex_order() {
+						Vertex *temp = v[0];
+						v[0] = v[1];
+						v[1] = temp;
+					}
+			};
+
+			Parameters parameters;
+
+		private:
+			float total_time;							//the start time of the next trace
+			float trace_dimension;						//of the trace classified last, -1 before classify()
+			float trace_period;							//found by the last generate(), -1 for none
+			std::vector<Math::Vector3D> spiro_points;	//the last trace
+			std::vector<Math::Vector3D> trimmed_points;
+
+			//surface
+			std::vector<Vertex> vertices_list;					//reserved up front, vertices never move
+			Geometry::Adjacency nearby_vertices;				//vertices within 3.5 * point_r, indexed like vertices_list
+			Geometry::EdgeNeighbourCache edge_neighbours;		//common nearby vertices of the frontier's edges
+			Utils::Pool<Triangle> triangle_pool;				//owns every triangle, released at once in dispose()
+			std::vector<Triangle *> surface_triangles;			//in the order they were added
+			Geometry::EdgeMesh surface_edges;					//edge -> triangles, indexed like vertices_list and surface_triangles
+			std::vector<Triangle *> active_triangles, next_active_triangles;	//the frontier, swapped every growth step
+
+			Triangle *add_triangle(Vertex *a, Vertex *b, Vertex *c);
+
+			//appends the triangles built on the open edges of t to list
+			void build_aoround(const Triangle &t, std::vector<Triangle *> &list);
+
+		public:
+			SurfacePipeline(const Parameters &parameters = Parameters());
+			SurfacePipeline(const SurfacePipeline &) = delete;
+			SurfacePipeline &operator=(const SurfacePipeline &) = delete;
+
+			/*
+			traces parameters.steps samples, continuing from where the last trace ended (from
+			parameters.start_time the first time).
+			when the spirograph closes within that time (see Spirograph::period), the trace stops one
+			sample after a full period, since every later sample would land on the same curve.
+			*/
+			void generate();
+
+			/*
+			estimates the intrinsic dimension of the trace at the scale of point_r, from a subsample
+			(see Geometry::intrinsic_dimension), and returns how likely it is to form a surface.
+			a small fraction of the cost of trimming, so line like (and volume like) traces can be
+			rejected before meshing.
+			a trace capped at a period is estimated like any other: a closed curve that winds densely
+			is still a surface at point_r, and one too short to tell is unknown (likelihood 0).
+			*/
+			float classify();
+
+			//combines points so no two points will be within point_r of each other
+			void trim();
+
+			/*
+			copies the trimmed points into vertices(), finds their neighbours and adds the first
+			triangle, which becomes the frontier. an existing surface is released first.
+			nothing is added when there are less than 3 points.
+			*/
+			void create_surface();
+
+			/*
+			builds the triangles around the frontier, which then become the new frontier.
+			returns the number of triangles added.
+			*/
+			int grow();
+
+			/*
+			runs the whole pipeline: generate, trim, create_surface, and grow until the frontier is
+			empty or after max_growth_steps. returns the number of growth steps.
+			when parameters.min_surface_likelihood is set, the trace is classified first, and a trace
+			that is less likely than that to form a surface is left without points and surface.
+			*/
+			int run(int max_growth_steps);
+
+			//releases the surface, the parameters and the trace are kept
+			void dispose();
+
+			inline const std::vector<Math::Vector3D> &trace() const {return spiro_points;}
+			inline const std::vector<Math::Vector3D> &trimmed() const {return trimmed_points;}
+			inline const std::vector<Vertex> &vertices() const {return vertices_list;}
+			inline const std::vector<Triangle *> &triangles() const {return surface_triangles;}
+			inline const std::vector<Triangle *> &frontier() const {return active_triangles;}
+			inline float dimension() const {return trace_dimension;}
+			//the period the last trace was capped at, -1 when the spirograph doesn't close within parameters.steps
+			inline float period() const {return trace_period;}
+			inline float surface_likelihood() const {return trace_dimension < 0.0f ? 0.0f : Geometry::surface_likelihood(trace_dimension);}
+	};
+}
+
+#endif
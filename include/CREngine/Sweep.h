@@ -0,0 +1,89 @@
+#ifndef CRENGINE_PUBLIC_HEADER_SWEEP
+#define CRENGINE_PUBLIC_HEADER_SWEEP
+
+#include <CREngine/Math.h>
+#include <CREngine/SurfacePipeline.h>
+
+#include <ostream>
+#include <vector>
+
+namespace CREngine {
+	namespace Sweep {
+		//count evenly spaced values from first to last (both included), a single value for count = 1
+		struct Range {
+			float first, last;
+			int count;
+
+			Range(float value = 0.0f) : first(value), last(value), count(1) {}
+			Range(float first, float last, int count) : first(first), last(last), count(count < 1 ? 1 : count) {}
+
+			inline float value(int i) const {return count == 1 ? first : first + (last - first) * i / (count - 1);}
+		};
+
+		struct HandleRange {
+			Range axis[3];		//x, y, z of the axis (magnitude = anglular frequency)
+			Range length;
+		};
+
+		/*
+		the parameter space of a sweep, every combination of the values of every range is one
+		configuration. the parameters that aren't swept (angle_cos_limit, backend, start_time) are
+		taken from base.
+		*/
+		struct Ranges {
+			std::vector<HandleRange> handles;
+			Range steps, step_delta, point_r;
+			SurfacePipeline::Parameters base;
+			int max_growth_steps;
+
+			Ranges() : max_growth_steps(1000) {}
+		};
+
+		/*
+		the metrics of one configuration.
+		coverage is the fraction of the trimmed points that the surface reached, surface_likeness the
+		fraction of the surface's edges that are shared by two triangles (a closed surface has 1, a
+		strip grown along a line has almost 0). score = coverage * surface_likeness.
+		dimension is the intrinsic dimension of the trace, -1 when parameters.min_surface_likelihood
+		is 0 and the trace isn't classified, or when the trace is too sparse at point_r to tell (then
+		it is rejected). a configuration rejected by the classifier has no
+		points or triangles, and scores 0.
+		*/
+		struct Result {
+			int configuration;		//the index in the sweep
+			SurfacePipeline::Parameters parameters;
+			Math::Vector3D box_min, box_max;		//bounding box of the trace
+			float period;		//that the trace was capped at, -1 for none
+			float dimension, surface_likelihood;
+			bool meshed;		//false when the classifier skipped the surface
+			int trimmed_points, triangles, growth_steps;
+			float coverage, surface_likeness, score;
+			float milliseconds;
+		};
+
+		//number of configurations in the sweep
+		long configuration_count(const Ranges &ranges);
+
+		/*
+		the parameters of configuration index. the last range changes fastest: handles in order
+		(x, y, z, length for each), then steps, step_delta and point_r.
+		*/
+		SurfacePipeline::Parameters configuration(const Ranges &ranges, long index);
+
+		//runs the pipeline on one configuration, tracing on a single thread
+		Result evaluate(const SurfacePipeline::Parameters &parameters, int max_growth_steps);
+
+		/*
+		evaluates every configuration of the sweep on up to 'threads' worker threads (0 = one per
+		hardware thread), and returns the results ranked by score, best first.
+		every worker starts with an even share of the configurations and, once it runs out, steals
+		half of what is left to another worker, so slow configurations don't hold the sweep back.
+		*/
+		std::vector<Result> run(const Ranges &ranges, int threads = 0);
+
+		//writes the results as a tab separated table, one row per configuration in the given order
+		void write_table(std::ostream &out, const std::vector<Result> &results);
+	}
+}
+
+#endif
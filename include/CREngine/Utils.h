@@ -1,7 +1,9 @@
 #ifndef CRENGINE_PUBLIC_HEADER_UTILS
 #define CRENGINE_PUBLIC_HEADER_UTILS
 
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace CREngine {
@@ -19,6 +21,47 @@ namespace CREngine {
 
 				std::string get_name() const;
 		};
+
+		/*
+		allocates objects of type T in chunks of CHUNK_SIZE, consecutive objects share a chunk.
+		chunks never move, so pointers stay valid until clear(), which destroys every object at once
+		but keeps the chunks for reuse. the chunks are released with the pool.
+		*/
+		template<class T, int CHUNK_SIZE = 1024>
+		class Pool {
+			private:
+				std::vector<T *> chunks;
+				int count;
+
+			public:
+				Pool() : count(0) {}
+				Pool(const Pool &) = delete;
+				Pool &operator=(const Pool &) = delete;
+
+				~Pool() {
+					clear();
+					for (T *chunk : chunks)
+						::operator delete(chunk);
+				}
+
+				template<class... Args>
+				T *create(Args&&... args) {
+					int chunk = count / CHUNK_SIZE;
+					if (chunk == chunks.size())
+						chunks.push_back(static_cast<T *>(::operator new(sizeof(T) * CHUNK_SIZE)));
+					T *object = new (chunks[chunk] + count % CHUNK_SIZE) T(std::forward<Args>(args)...);
+					count++;
+					return object;
+				}
+
+				void clear() {
+					for (int i = 0; i < count; ++i)
+						chunks[i / CHUNK_SIZE][i % CHUNK_SIZE].~T();
+					count = 0;
+				}
+
+				inline int size() const {return count;}
+		};
 	}
 }
 
@@ -7,6 +7,8 @@
 #include <CREngine/AssetManager.h>
 #include <CREngine/RenderUtils.h>
 #include <CREngine/GUI.h>
+#include <CREngine/Spirograph.h>
+#include <CREngine/SurfacePipeline.h>
 #include <functional>
 #include <CREngine/InputManager.h>
 
@@ -63,522 +65,276 @@ static Math::Vector2D mouse_p_frame, mouse_frame;
 static Math::Vector2D camera_v;
 
 //resources
-static RenderUtils::Batcher b("spiro_batcher"), h("handle_batcher"), g("grid"), t("points"), s("surface");
+static RenderUtils::Batcher b("spiro_batcher"), h("handle_batcher"), g("grid"), a("axes"), t("points");
+static RenderUtils::IndexedBatcher s("surface");
 static RenderUtils::Shader *shader, *surface_shader;
+static GLint line_color, surface_color;		//uniform locations
 
-//spirograph parts
-static std::vector<std::tuple<Math::Vector3D, float>> spiro_structure;	//axis (magnitude = anglular frequency), length
-static std::vector<Math::Matrix3D> spiro_rotation_matrices;
-static std::vector<Math::Vector3D> spiro_handles;
-
-//spirograph trace
-static std::vector<float> spiro_points_buffer;
-static std::vector<Math::Vector3D> spiro_points;
-
-//program runtime
-static float total_time = 0.001f;
-
-//spirograph surface
-class Triangle;
-class Vertex;
-static std::vector<Math::Vector3D> trimmed_points;
-static std::vector<Vertex> vertices_list;
-static std::vector<Triangle *> spiro_surface_triangles;
-static std::vector<Triangle *> active_triangles;
-int steps;
-float step_delta;
-float point_r = 0.1f;			//minimum spacing between elements
-float angle_cos_limit = 45.0f;	//filtering the direction of the tirangle surfaces
-
-
-class Vertex : public Math::Vector3D {
-public:
-	std::vector<Vertex *> nearby_vertices;
-	std::vector<Triangle *> connected_triangles;
-
-	Vertex(const Math::Vector3D &position) : Vector3D(position) {}
-
-	void remove_nearby_vertex(const Vertex *v) {
-		for (int i = 0; i < nearby_vertices.size(); ++i) {
-			if (nearby_vertices[i] == v) {
-				nearby_vertices.erase(nearby_vertices.begin() + i);
-				return;
-			}
-		}
-	}
-
-	bool connected_to_triangle(const Triangle *t) const {
-		for (int i = 0; i < connected_triangles.size(); ++i)
-		{
-			if (connected_triangles[i] == t)
-			{
-				return true;
-			}
-		}
-		return false;
-	}
-
+//the Camera block of line.vert and surface.vert (std140, matrices are column-major on both sides)
+struct CameraBlock {
+	Math::Matrix4D view, projection;
 };
+static_assert(sizeof(CameraBlock) == 2 * 16 * sizeof(float), "CameraBlock has to match the std140 layout");
+static const GLuint CAMERA_BINDING = 0;
+static RenderUtils::UniformBuffer camera_block("camera_block");
 
-class Triangle {
-public:
-	Vertex *v[3];
-	Triangle(Vertex *a, Vertex *b, Vertex *c) : v{a, b, c} {
-		a->connected_triangles.push_back(this);
-		b->connected_triangles.push_back(this);
-		c->connected_triangles.push_back(this);
-	}
-
-	Math::Vector3D normal() const {
-		return (*v[1] - *v[0]).cross(*v[2] - *v[1]).normalize();
-	}
-
-	Math::Vector3D center() const {
-		return (*v[0] + *v[1] + *v[2]) * (1.0f / 3.0f);
-	}
-
-	void flip_vertex_order() {
-		Vertex *temp = v[0];
-		v[0] = v[1];
-		v[1] = temp;
-	}
-
-	std::vector<Triangle *> build_aoround() {
-		std::vector<Triangle *> list;
-
-		//iterate over edges
-		for (int i = 0; i < 3; ++i) {
-			Vertex *a = v[i];
-			Vertex *b = v[(i + 1) % 3];
-
-			Vertex *c = nullptr;
-
-			Math::Vector3D line_normal = (*b - *a).cross(normal()).normalize();
-			Math::Vector3D line_center = (*b + *a) * 0.5f;
-
-			float max_angle_cos = cos(angle_cos_limit * 3.141f / 180.0f);
-			float min_distance = point_r * 10.0f;
-			float distance = 0;
-			for (int i_a = 0; i_a < a->nearby_vertices.size(); ++i_a) {
-				Vertex *v = a->nearby_vertices[i_a];
-				for (int i_b = 0; i_b < b->nearby_vertices.size(); ++i_b) {
-					if (v == b->nearby_vertices[i_b]) {		//common nearby vertex for the edge
-						//the angle cosine of the vector on the triangles plane and normal to the edge
-						float angle_cos = (*v - line_center).angle_cos(line_normal);
-						if (angle_cos > max_angle_cos) {	//checking the deviation of the line direction vector
-							Math::Vector3D new_normal = (*v - *a).cross(*b - *v).normalize();	//the new normal of the new triangle
-							for (Triangle *t2: a->connected_triangles) {	//keeping from binding to the same triangle
-								for (Triangle *t3: b->connected_triangles) {
-									if (t2 == t3 && t2 != this) {
-										if (new_normal.angle_cos(normal()) > 0.0f) {	//filtering the lines outside the direction of the surface
-											goto end;
-										}
-									}
-								}
-							}
-							
-							distance = line_center.distance_from(*v);
-							if (distance < min_distance) {		//picking the closest point which passed the filters
-								min_distance = distance;
-								c = v;
-							}
-
-							end:;
-						}
-					}
-				}
-			}
-			if (c != nullptr) {
-				Triangle *triangle = new Triangle(a, c, b);
-				list.push_back(triangle);
-			}
-		}
-		return list;
-	}
-};
-
-
-//debug herlpers
-static std::vector<Math::Vector3D> extra_points;
+//spirograph surface
+static SurfacePipeline pipeline;
+static int uploaded_triangles = 0;				//pipeline.triangles() before this index are already in s
+static std::vector<GLuint> surface_indices;		//staging for the triangles uploaded by a growth step
 
 /*
-calculates and adds the current position of the spirograph to spiro_points
+appends the triangles that were added since the last call to the surface batcher, as indices
+into pipeline.vertices(). the vertices themselves are uploaded once, and the normals are computed per
+triangle in surface.frag, so the cost follows the new triangles, not the whole surface.
 */
-static void spiro_step() {
-	using namespace CREngine::Math;
-
-	Math::Vector3D origin;
-	for (int i = 0; i < spiro_structure.size(); ++i) {
-		spiro_handles.emplace_back(std::get<1>(spiro_structure[i]), 0.0f, 0.0f);
-		origin += spiro_handles.back();
-	}
-
-	Math::Vector3D head = origin;
-	for (int i = spiro_structure.size() - 1; i >= 0; --i) {
-		origin -= spiro_handles[i];
-		Matrix3D rotation_matrix = Math::Matrix3D::rotation(std::get<0>(spiro_structure[i]) * total_time);
-
-		head -= origin;
-		head = rotation_matrix * head;
-		head += origin;
+static void upload_new_triangles() {
+	const std::vector<SurfacePipeline::Triangle *> &triangles = pipeline.triangles();
+
+	surface_indices.clear();
+	for (int i = uploaded_triangles, m = triangles.size(); i < m; ++i) {
+		const SurfacePipeline::Triangle &t = *triangles[i];
+		for (int j = 0; j < 3; ++j)
+			surface_indices.push_back(t.v[j]->index());
 	}
-
-	spiro_points_buffer.push_back(head[0]);
-	spiro_points_buffer.push_back(head[1]);
-	spiro_points_buffer.push_back(head[2]);
-	spiro_points_buffer.push_back(0.0f);
-	spiro_points_buffer.push_back(0.0f);
-	spiro_points_buffer.push_back(0.0f);
-
-	spiro_points.push_back(Math::Vector3D(head[0], head[1], head[2]));
+	s.append_indices(surface_indices.data(), surface_indices.size());
+	uploaded_triangles = triangles.size();
 }
 
 /*
-uses spiro_step to create a full spirograph.
-controls spiro_points
+traces the next part of the spirograph with pipeline.generate().
 */
 static void create_spirograph() {
-	for (int i = 0; i < steps; ++i) {
-		spiro_step();
-		total_time += step_delta;
-	}
+	pipeline.generate();
+
+	//read straight from the trace into the batcher's mapped buffer
 	b.clear();
-	b.add_data(&spiro_points_buffer[0], spiro_points_buffer.size());
+	b.add_vertices(RenderUtils::StridedView(pipeline.trace()));
 	b.update();
 }
 
-/*
-combines points so no two points will be within point_r of each other.
-controls trimmed_points
-*/
-static void trim_points() {
-	int points_left = spiro_points.size();
-	Math::Vector3D **points = new Math::Vector3D*[points_left];
-	for (int i = 0; i < points_left; ++i) {
-		points[i] = &spiro_points[i];
-	}
-
-	int start = 0, end;
-	while(points_left > 0) {
-		Math::Vector3D point = *points[0];
-		while(points[start] == nullptr) start++;
-		trimmed_points.push_back(*points[start]);
-
-		end = points_left + start;
-
-		int removed = 0;
-		for (int i = start; i < end; ++i) {
-			if (point.distance_from(*points[i]) < point_r) {
-				removed++;
-				points[i] = nullptr;
-			}
-		}
-
-
-		for (int i = start, j = start; i < end; ++i) {
-			if (points[i] == nullptr) continue;
-			points[j++] = points[i];
-		}
-
-		points_left -= removed;
-	}
-}
-
-static void create_surfrace() {
-	//make a copy of (Vector3D) trimmed_points to (Vertex) vertices_list
-	for (int i = 0; i < trimmed_points.size(); ++i) {
-		vertices_list.emplace_back(trimmed_points[i]);
-	}
-	//calculate nerarby points
-	for (int i = 0; i < vertices_list.size(); ++i) {
-		Vertex *v = &vertices_list[i];
-		for (int j = 0; j < vertices_list.size(); ++j) {
-			if (j == i) continue;
-			Vertex *w = &vertices_list[j];
-			if (v->distance_from(*w) <= 3.5f * point_r) {
-				v->nearby_vertices.push_back(w);
-			}
-		}
-	}
-
-	//calculate the gemetric center
-	Math::Vector3D center;
-	for (int i = 0; i < vertices_list.size(); ++i)
-		center += vertices_list[i];
-	center = center * (1.0f / vertices_list.size());
-
-	//pick the point furthest away from the center
-	float max_distance = vertices_list[0].distance_from(center);
-	int max_distance_index = 0;
-	for (int i = 1; i < vertices_list.size(); ++i){
-		float d = vertices_list[i].distance_from(center);
-		if (d > max_distance) {
-			d = max_distance;
-			max_distance_index = i;
-		}
-	}
-	const Math::Vector3D &max_distance_vector = vertices_list[max_distance_index];
-
-	//guess the normal for that point
-	Math::Vector3D normal = (vertices_list[max_distance_index] - center).normalize();
-
-	//find next point with minimal angle from max point
-	int min_angle_index = 0;
-	float min_angle = -1.0f;
-	for (int i = 0; i < vertices_list.size(); ++i) {
-		if (i == max_distance_index) continue;
-		Math::Vector3D &v = vertices_list[i];
-		if (v.distance_from(vertices_list[max_distance_index]) > 3.0f * point_r) continue; 
-
-		float c = (vertices_list[i] - max_distance_vector).angle_cos(normal);
-		
-		//EDIT
-
-		if (c > min_angle) {	//cosine bigger for smaller angles
-			min_angle = c;
-			min_angle_index = i;
-		}
-	}
-	const Math::Vector3D &min_angle_vector = vertices_list[min_angle_index];
-
-	//adjust the normal
-	Math::Vector3D line_center = (max_distance_vector + min_angle_vector) * 0.5f;
-	//normal = (line_center - center).normalize();
-
-	//complete the triangle with a final point that will have minimum angle from the normal
-	float min_normal = -1.0f;
-	int min_normal_index = -1;
-	for (int i = 0; i < vertices_list.size(); ++i) {
-		if (i == max_distance_index || i == min_angle_index) continue;
-		float c = (vertices_list[i] - center).angle_cos(normal);
-		if (c >= min_normal) {	//cosine bigger for smaller angles
-			min_normal = c;
-			min_normal_index = i;
-		}
-	}
-
-	//fix normal if needed
-	Triangle *t = new Triangle( 
-		&vertices_list[min_angle_index],
-		&vertices_list[max_distance_index],
-		&vertices_list[min_normal_index]
-	);
-
-	if ((t->center() - center).angle_cos(t->normal()) < 0.0f) {
-		//t->flip_vertex_order();
-	}
-
-	//spiro_surface_triangles
-	spiro_surface_triangles.push_back(t);
-
-	active_triangles.push_back(t);
-}
-
 static void create_spirograph_surface() {
 	//make a set of points which is easier to work with
-	trim_points();
+	pipeline.trim();
+	const std::vector<Math::Vector3D> &trimmed_points = pipeline.trimmed();
 
 	//create a buffer for rendering the new set of points
-	t.init(trimmed_points.size() * 6, std::vector<int> {3, 3});
+	t.init_streaming(trimmed_points.size(), std::vector<RenderUtils::Layout> {RenderUtils::Layout(3, GL_HALF_FLOAT)});
 	t.mode = GL_POINTS;
 	t.clear();
-	std::vector<float> data(trimmed_points.size() * 6);
-	for (int i = 0; i < trimmed_points.size(); ++i) {
-		data[i * 6 + 0] = trimmed_points[i][0];
-		data[i * 6 + 1] = trimmed_points[i][1];
-		data[i * 6 + 2] = trimmed_points[i][2];
-		data[i * 6 + 3] = 0.0f;
-		data[i * 6 + 4] = 0.5f;
-		data[i * 6 + 5] = 0.8f;
-	}
-	t.add_data(&data[0], data.size());
+	t.add_vertices(RenderUtils::StridedView(trimmed_points));
 	t.update();
 
 	//create the surface buffer
-	create_surfrace();
-	s.init(trimmed_points.size() * 3 * (3 + 3 + 3), std::vector<int> {3, 3, 3});	//3 vectors per triangle, poisition, normal, color per vector
+	pipeline.create_surface();
+	const std::vector<SurfacePipeline::Vertex> &vertices_list = pipeline.vertices();
+	//one vertex per element of vertices_list, about 2 triangles per vertex
+	s.init(vertices_list.size(), vertices_list.size() * 6, std::vector<RenderUtils::Layout> {RenderUtils::Layout(3, GL_HALF_FLOAT)});	//poisition per vertex
+	s.clear();
+	s.clear_indices();
+	if (!vertices_list.empty())		//create_surface() adds no vertices for less than 3 points
+		s.add_vertices(RenderUtils::StridedView(vertices_list[0].v, vertices_list.size(), 3, sizeof(SurfacePipeline::Vertex) / sizeof(float)));
+	s.update();
+	uploaded_triangles = 0;
+	upload_new_triangles();
 }
 
 void init() {
+	SurfacePipeline::Parameters &parameters = pipeline.parameters;
+
 	//create batchers
-	b.init(100000, std::vector<int> {3, 3});
-	b.mode = GL_LINE_STRIP;
-	h.init(200, std::vector<int> {3, 3});
+	//positions only, the colors are uniforms. b is created with the spirograph, its size follows parameters.steps
+	h.init(200, std::vector<int> {3});
 	h.mode = GL_LINE_STRIP;
-	g.init(400, std::vector<int> {3, 3});
+	g.init(400, std::vector<int> {3});
 	g.mode = GL_LINES;
+	a.init(6, std::vector<int> {3});
+	a.mode = GL_LINES;
 
 	//create the grid
 	float l = 2.0f, dl = 0.5f;
-	g.clear();
+	a.clear();
 	{
-		std::vector<float> data = {	//axis
+		float data[] = {	//axis
 			//x
-			-l, 0.0f, 0.0f,		0.0f, 0.0f, 0.0f,
-			l, 0.0f, 0.0f,		0.0f, 0.0f, 0.0f,
+			-l, 0.0f, 0.0f,
+			l, 0.0f, 0.0f,
 			//y
-			0.0f, -l, 0.0f,		0.0f, 0.0f, 0.0f,
-			0.0f, l, 0.0f,		0.0f, 0.0f, 0.0f,
+			0.0f, -l, 0.0f,
+			0.0f, l, 0.0f,
 			//y
-			0.0f, 0.0f, -l,		0.0f, 0.0f, 0.0f,
-			0.0f, 0.0f, l,		0.0f, 0.0f, 0.0f,
+			0.0f, 0.0f, -l,
+			0.0f, 0.0f, l,
 		};
-		g.add_data(&data[0], data.size());
+		a.add_data(data, sizeof(data) / sizeof(float));
 	}
-	float c_r = 0.4f, c_g = 0.4f, c_b = 0.4f;
+	a.update();
+	g.clear();
 	for (float i = -l; i <= l; i += dl) {
 		//along x
-		std::vector<float> data = {	//axis
+		float data[] = {	//axis
 			//x
-			-l, 0.0f, i,		c_r, c_g, c_b,
-			l, 0.0f, i,			c_r, c_g, c_b,
+			-l, 0.0f, i,
+			l, 0.0f, i,
 			//z
-			i, 0.0f, -l,		c_r, c_g, c_b,
-			i, 0.0f, l,			c_r, c_g, c_b
+			i, 0.0f, -l,
+			i, 0.0f, l
 		};
-		g.add_data(&data[0], data.size());
+		g.add_data(data, sizeof(data) / sizeof(float));
 	}
 	g.update();
 
 	//load shader
 	shader = AssetManager::get_shader("line_shader");
 	surface_shader = AssetManager::get_shader("surface_shader");
+	line_color = shader->get_uniform_location("color");
+	surface_color = surface_shader->get_uniform_location("color");
+
+	camera_block.init(CAMERA_BINDING, sizeof(CameraBlock));
+	shader->bind_block("Camera", CAMERA_BINDING);
+	surface_shader->bind_block("Camera", CAMERA_BINDING);
 
 	//define the spirograph
-	//spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.013f, 0.0f), 0.9f});
-	//spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 1.0f), 0.5f});
-	//steps = 20000;
-	//step_delta = 0.1f;
-
-	//spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.1f, 0.0f), 0.5f});
-	//spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.0f, 1.0f), 0.5f});
-	//spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.0f, 1.0f), 0.5f});
-	//steps = 20000;
-	//step_delta = 0.1f;
-
-	/*spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.3f, 0.0f), 0.8f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.3f, 1.0f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, -0.1f, -1.1f), 0.5f});
-	steps = 20000;
-	step_delta = 0.09f;
-	point_r = 0.08f;*/
+	//parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.013f, 0.0f), 0.9f});
+	//parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 1.0f), 0.5f});
+	//parameters.steps = 20000;
+	//parameters.step_delta = 0.1f;
+
+	//parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.1f, 0.0f), 0.5f});
+	//parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.0f, 1.0f), 0.5f});
+	//parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.0f, 1.0f), 0.5f});
+	//parameters.steps = 20000;
+	//parameters.step_delta = 0.1f;
+
+	/*parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.3f, 0.0f), 0.8f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.3f, 1.0f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, -0.1f, -1.1f), 0.5f});
+	parameters.steps = 20000;
+	parameters.step_delta = 0.09f;
+	parameters.point_r = 0.08f;*/
 
 	//pick
-	/*spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(-0.3f, 0.0f, 0.0f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.3f, 0.0f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, -0.31f), 0.5f});
-	steps = 20000;
-	step_delta = 0.09f;
-	point_r = 0.08f;*/
+	/*parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(-0.3f, 0.0f, 0.0f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.3f, 0.0f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, -0.31f), 0.5f});
+	parameters.steps = 20000;
+	parameters.step_delta = 0.09f;
+	parameters.point_r = 0.08f;*/
 
 	/*//pick - maybe
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(-0.7f, 0.1f, 0.1f), 1.0f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 1.0f), 1.5f});
-	steps = 10000;
-	step_delta = 0.09f;
-	point_r = 0.02f;
-	angle_cos_limit = 30.0f;*/
-
-	//spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.1f, 0.0f), 0.5f});
-	//spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.0f, 1.0f), 0.5f});
-	//spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.0f, 1.0f), 0.5f});
-	//steps = 20000;
-	//step_delta = 0.1f;
-
-	/*spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 0.1f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.1f, 0.0f), 1.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.1f, 0.1f, 0.1f), 1.5f});
-	steps = 100000;
-	step_delta = 0.1f;
-	//point_r = 0.07f;*/
-
-	/*spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 0.1f), 1.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.11f, 0.0f), 1.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.11f, 0.1f, 0.1f), 1.5f});
-	//steps = 10000;
-	steps = 100000;
-	//steps = 100000;
-	step_delta = 0.2f;
-	//point_r = 0.07f;
-	//point_r = 0.07f;*/
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(-0.7f, 0.1f, 0.1f), 1.0f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 1.0f), 1.5f});
+	parameters.steps = 10000;
+	parameters.step_delta = 0.09f;
+	parameters.point_r = 0.02f;
+	parameters.angle_cos_limit = 30.0f;*/
+
+	//parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.1f, 0.0f), 0.5f});
+	//parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.0f, 1.0f), 0.5f});
+	//parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.0f, 1.0f), 0.5f});
+	//parameters.steps = 20000;
+	//parameters.step_delta = 0.1f;
+
+	/*parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 0.1f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.1f, 0.0f), 1.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.1f, 0.1f, 0.1f), 1.5f});
+	parameters.steps = 100000;
+	parameters.step_delta = 0.1f;
+	//parameters.point_r = 0.07f;*/
+
+	/*parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 0.1f), 1.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.11f, 0.0f), 1.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.11f, 0.1f, 0.1f), 1.5f});
+	//parameters.steps = 10000;
+	parameters.steps = 100000;
+	//parameters.steps = 100000;
+	parameters.step_delta = 0.2f;
+	//parameters.point_r = 0.07f;
+	//parameters.point_r = 0.07f;*/
 
 	/*//pick
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.1f, 0.0f, 0.1f), 0.7f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.1f, 0.0f, 0.0f), 1.0f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 0.1f), 1.0f});
-	steps = 50000;
-	step_delta = 0.1f;
-	//point_r = 0.07f;*/
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.1f, 0.0f, 0.1f), 0.7f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.1f, 0.0f, 0.0f), 1.0f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 0.1f), 1.0f});
+	parameters.steps = 50000;
+	parameters.step_delta = 0.1f;
+	//parameters.point_r = 0.07f;*/
 
 	/*//pick
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.1f, 0.0f, 0.0f), 1.0f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.1f, 0.0f), 1.0f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(-0.1f, 0.0f, 0.0f), 1.0f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.117f, 0.0f), 0.2f});
-	steps = 50000;
-	step_delta = 0.1f;
-	point_r = 0.09f;*/
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.1f, 0.0f, 0.0f), 1.0f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.1f, 0.0f), 1.0f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(-0.1f, 0.0f, 0.0f), 1.0f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.117f, 0.0f), 0.2f});
+	parameters.steps = 50000;
+	parameters.step_delta = 0.1f;
+	parameters.point_r = 0.09f;*/
 	
 
 	//pick
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.2f, 0.0f, 0.0f), 1.0f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.3f, 0.0f), 1.0f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(-0.1f, 0.0f, 0.0f), 1.0f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.3f, 0.0f), 0.2f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0117f, 0.0f), 0.2f});
-	steps = 50000;
-	step_delta = 0.1f;
-	point_r = 0.09f;
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.2f, 0.0f, 0.0f), 1.0f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.3f, 0.0f), 1.0f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(-0.1f, 0.0f, 0.0f), 1.0f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.3f, 0.0f), 0.2f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0117f, 0.0f), 0.2f});
+	parameters.steps = 50000;
+	parameters.step_delta = 0.1f;
+	parameters.point_r = 0.09f;
 	
 
 	//pick
-	/*spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.1f, 1.0f, 0.0f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.0f, 1.0f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.0f, 1.0f), 0.5f});
-	steps = 20000;
-	step_delta = 0.1f;
-	point_r = 0.05f;*/
-
-	/*spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, -0.3f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.3f, 1.0f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(-1.3f, -0.3f, 1.0f), 0.5f});
-	steps = 20000;
-	step_delta = 0.1f;
-	point_r = 0.1f;*/
-
-	//spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.0f, 1.0f).normalize() * 0.11f, 1.0f});
-	//spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 1.0f).normalize(), 0.5f});
-	//spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 2.0f, 1.0f).normalize(), 0.5f});
-	//steps = 20000;
-	//step_delta = 0.1f;
-
-	/*spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.01f, 0.0f), 0.0f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 1.0f), 1.5f});
-	//steps = 20000;
-	steps = 20000;
-	step_delta = 0.1f;*/
-
-	/*spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.0f, 0.0f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 1.0f, 0.0f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.0f, 1.0f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -1.0f, 1.0f), 0.5f});
-	//steps = 50000;
-	steps = 10000;
-	step_delta = 0.1f;
-	point_r = 0.07f;*/
-
-	/*spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 1.0f, 0.0f) * sqrt(2), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, -1.0f, 0.0f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.0f, 1.0f), 0.5f});
-	spiro_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -1.0f, 1.0f), 0.5f});
-	//steps = 50000;
-	steps = 10000;
-	step_delta = 0.08f;
-	point_r = 0.07f;
-	angle_cos_limit = 30.0f;*/
-
-	//create the spirograph
+	/*parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.1f, 1.0f, 0.0f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.0f, 1.0f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.0f, 1.0f), 0.5f});
+	parameters.steps = 20000;
+	parameters.step_delta = 0.1f;
+	parameters.point_r = 0.05f;*/
+
+	/*parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, -0.3f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.3f, 1.0f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(-1.3f, -0.3f, 1.0f), 0.5f});
+	parameters.steps = 20000;
+	parameters.step_delta = 0.1f;
+	parameters.point_r = 0.1f;*/
+
+	//parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.0f, 1.0f).normalize() * 0.11f, 1.0f});
+	//parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 1.0f).normalize(), 0.5f});
+	//parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 2.0f, 1.0f).normalize(), 0.5f});
+	//parameters.steps = 20000;
+	//parameters.step_delta = 0.1f;
+
+	/*parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.01f, 0.0f), 0.0f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 1.0f), 1.5f});
+	//parameters.steps = 20000;
+	parameters.steps = 20000;
+	parameters.step_delta = 0.1f;*/
+
+	/*parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 0.0f, 0.0f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 1.0f, 0.0f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.0f, 1.0f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -1.0f, 1.0f), 0.5f});
+	//parameters.steps = 50000;
+	parameters.steps = 10000;
+	parameters.step_delta = 0.1f;
+	parameters.point_r = 0.07f;*/
+
+	/*parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, 1.0f, 0.0f) * sqrt(2), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(1.0f, -1.0f, 0.0f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.0f, 1.0f), 0.5f});
+	parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -1.0f, 1.0f), 0.5f});
+	//parameters.steps = 50000;
+	parameters.steps = 10000;
+	parameters.step_delta = 0.08f;
+	parameters.point_r = 0.07f;
+	parameters.angle_cos_limit = 30.0f;*/
+
+	//create the spirograph, every trace is parameters.steps samples at most
+	b.init_streaming(parameters.steps, std::vector<RenderUtils::Layout> {RenderUtils::Layout(3, GL_HALF_FLOAT)});
+	b.mode = GL_LINE_STRIP;
 	create_spirograph();
+	if (pipeline.period() < 0.0f)
+		print("the spirograph doesn't close within", parameters.steps, "steps");
+	else
+		print("the spirograph closes after", pipeline.period(), "- traced", pipeline.trace().size(), "of", parameters.steps, "steps");
 	create_spirograph_surface();
 }
 
@@ -588,42 +344,8 @@ void handle_input() {
 
 	if (InputManager::keys[InputManager::KEYS::KEY_SPACE] == InputManager::JUST_PRESSED || InputManager::keys[InputManager::KEYS::KEY_SPACE] == InputManager::DOWN) {
 		//step forward
-		std::vector<Triangle *> new_active;
-		for (int i = 0; i < active_triangles.size(); ++i) {
-			std::vector<Triangle *> list = active_triangles[i]->build_aoround();
-			for (int j = 0; j < list.size(); ++j) {
-				new_active.push_back(list[j]);
-				spiro_surface_triangles.push_back(list[j]);
-			}
-		}
-		active_triangles = new_active;
-
-		s.clear();
-		std::vector<float> surface_data(trimmed_points.size() * 1000 * 3 * (3 + 3 + 3));	//3 vectors per triangle, poisition, normal, color per vector
-		Math::Vector3D color(0.1f, 0.7f, 0.3f);
-		int count = 0;
-		for (int i = 0, m = spiro_surface_triangles.size(); i < m; ++i) {
-			const Triangle &t = *spiro_surface_triangles[i];
-			Math::Vector3D normal = t.normal();
-			for (int j = 0; j < 3; ++j) {
-				Math::Vector3D &position = *t.v[j];
-				/*Math::Vector3D normal;
-				for (Triangle *tr: t.v[j]->connected_triangles)
-					normal += tr->normal();*/
-				normal = normal.normalize();
-				surface_data[count++] = position[0];
-				surface_data[count++] = position[1];
-				surface_data[count++] = position[2];
-				surface_data[count++] = normal[0];
-				surface_data[count++] = normal[1];
-				surface_data[count++] = normal[2];
-				surface_data[count++] = color[0];
-				surface_data[count++] = color[1];
-				surface_data[count++] = color[2];
-			}
-		}
-		s.add_data(&surface_data[0], count);
-		s.update();
+		pipeline.grow();
+		upload_new_triangles();
 	}
 }
 
@@ -664,12 +386,16 @@ void render() {
 	glEnable(GL_PROGRAM_POINT_SIZE);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	CameraBlock camera_data = {camera.view, camera.projection};
+	camera_block.update(&camera_data, sizeof(camera_data));
+
 	shader->use();
-	shader->bind_mat("camera_view", camera.view);
-	shader->bind_mat("camera_projection", camera.projection);
-	
+	//shader->bind_vec(line_color, Math::Vector3D(0.4f, 0.4f, 0.4f));
 	//g.render();
+	//shader->bind_vec(line_color, Math::Vector3D(0.0f, 0.0f, 0.0f));
+	//a.render();
 	//b.render();
+	shader->bind_vec(line_color, Math::Vector3D(0.0f, 0.5f, 0.8f));
 	t.render();
 
 	surface_shader->use();
@@ -678,14 +404,13 @@ void render() {
 	camera.view[2].print();
 	camera.view[3].print();
 	std::cout<<std::endl;*/
-	surface_shader->bind_mat("camera_view", camera.view);
-	surface_shader->bind_mat("camera_projection", camera.projection);
+	surface_shader->bind_vec(surface_color, Math::Vector3D(0.1f, 0.7f, 0.3f));
 	s.render();
 }
 
 void dispose() {
-	for (int i = 0; i < spiro_surface_triangles.size(); ++i) 
-		delete spiro_surface_triangles[i];
+	pipeline.dispose();
+	uploaded_triangles = 0;
 }
 
 int main(int argc, char const *argv[]) {
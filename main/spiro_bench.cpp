@@ -0,0 +1,570 @@
+#include <CREngine/Spirograph.h>
+#include <CREngine/Geometry.h>
+#include <CREngine/SurfacePipeline.h>
+#include <CREngine/Sweep.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <thread>
+
+using namespace CREngine;
+
+template<class T>
+void print(T t) {
+	std::cout<<t<<std::endl;
+}
+
+template<class T, class... Args>
+void print(T t, Args ...args) {
+	std::cout<<t<<" ";
+	print(args...);
+}
+
+//the math types are usable in constant expressions
+static_assert(Math::Vector3D(1.0f, 2.0f, 3.0f).cross(Math::Vector3D(0.0f, 0.0f, 1.0f)).dot(Math::Vector3D(2.0f, -1.0f, 0.0f)) == 5.0f, "constexpr Vector3D");
+static constexpr Math::Matrix4D constant_matrix(Math::Vector4D(1, 2, 3, 4), Math::Vector4D(5, 6, 7, 8), Math::Vector4D(), Math::Vector4D());
+static_assert(constant_matrix(1, 0) == 5.0f && constant_matrix(0, 3) == 4.0f, "constexpr Matrix4D");
+
+static int failures = 0;
+
+//every heap allocation of the program goes through here, so each benchmark can report its count
+static std::atomic<long> allocations(0);
+
+void *operator new(size_t size) {
+	allocations++;
+	void *p = malloc(size == 0 ? 1 : size);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+//gcc inlines these into delete expressions and then sees free() on memory from operator new, but
+//that operator new is the one above, which allocates with malloc
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+/*
+runs f once and prints its duration, throughput and number of heap allocations
+*/
+static void benchmark(const std::string &name, int samples, const std::function<void()> &f) {
+	long allocations_before = allocations;
+	auto start = std::chrono::steady_clock::now();
+	f();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	print(name + ":", seconds * 1000.0, "ms,", samples / seconds / 1.0e6, "M samples/s,", allocations - allocations_before, "allocations");
+}
+
+/*
+the largest distance between matching points of a and b, over the first 'count' points
+*/
+static float max_deviation(const std::vector<Math::Vector3D> &a, const std::vector<Math::Vector3D> &b, int count) {
+	float deviation = 0.0f;
+	for (int i = 0; i < count; ++i)
+		deviation = std::max(deviation, a[i].distance_from(b[i]));
+	return deviation;
+}
+
+static void check(const std::string &name, float deviation, float tolerance) {
+	bool ok = deviation <= tolerance;
+	if (!ok) failures++;
+	print(ok ? "[ok]" : "[FAILED]", name, "- max deviation", deviation, "tolerance", tolerance);
+}
+
+int main(int argc, char const *argv[]) {
+	int steps = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	//the default structure of spiro_3d_v5
+	Spirograph::Structure structure;
+	structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.2f, 0.0f, 0.0f), 1.0f});
+	structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, -0.3f, 0.0f), 1.0f});
+	structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(-0.1f, 0.0f, 0.0f), 1.0f});
+	structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.3f, 0.0f), 0.2f});
+	structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0117f, 0.0f), 0.2f});
+	float t0 = 0.001f, step_delta = 0.1f;
+	float length = 3.4f;
+
+	print("samples:", steps, "handles:", structure.size());
+
+	//throughput
+	std::vector<Math::Vector3D> reference(steps), reference_quaternion(steps), scalar, simd, parallel, parallel_simd, batch(steps);
+	std::vector<float> times(steps), x(steps), y(steps), z(steps);
+	for (int i = 0; i < steps; ++i)
+		times[i] = (float) ((double) t0 + (double) i * step_delta);
+
+	benchmark("evaluate", steps, [&]() {
+		for (int i = 0; i < steps; ++i)
+			reference[i] = Spirograph::evaluate(structure, times[i]);
+	});
+	benchmark("evaluate_quaternion", steps, [&]() {
+		for (int i = 0; i < steps; ++i)
+			reference_quaternion[i] = Spirograph::evaluate_quaternion(structure, times[i]);
+	});
+	benchmark("trace (scalar)", steps, [&]() {scalar = Spirograph::trace(structure, t0, step_delta, steps);});
+	benchmark("trace (simd)", steps, [&]() {simd = Spirograph::trace(structure, t0, step_delta, steps, Spirograph::SIMD);});
+	benchmark("trace_parallel (scalar)", steps, [&]() {parallel = Spirograph::trace_parallel(structure, t0, step_delta, steps);});
+	benchmark("trace_parallel (simd)", steps, [&]() {parallel_simd = Spirograph::trace_parallel(structure, t0, step_delta, steps, 0, Spirograph::SIMD);});
+	benchmark("evaluate_batch", steps, [&]() {Spirograph::evaluate_batch(structure, &times[0], steps, &x[0], &y[0], &z[0]);});
+	for (int i = 0; i < steps; ++i)
+		batch[i].set(x[i], y[i], z[i]);
+
+	//correctness, evaluate() is only accurate while its float angles are (t < 1000)
+	int accurate = std::min(steps, (int) (1000.0f / step_delta));
+	check("trace (scalar) vs evaluate", max_deviation(scalar, reference, accurate), 1e-4f * length);
+	check("trace (simd) vs trace (scalar)", max_deviation(simd, scalar, steps), 1e-5f * length);
+	check("evaluate_quaternion vs evaluate", max_deviation(reference_quaternion, reference, accurate), 1e-5f * length);
+	//more handles than the specialized kernels cover goes through the generic one
+	Spirograph::Structure long_structure = structure;
+	long_structure.insert(long_structure.end(), structure.begin(), structure.end());
+	std::vector<Math::Vector3D> long_trace = Spirograph::trace(long_structure, t0, step_delta, accurate), long_reference(accurate);
+	for (int i = 0; i < accurate; ++i)
+		long_reference[i] = Spirograph::evaluate(long_structure, times[i]);
+	check("trace (10 handles) vs evaluate", max_deviation(long_trace, long_reference, accurate), 1e-4f * 2.0f * length);
+	check("trace_parallel (scalar) vs trace (scalar)", max_deviation(parallel, scalar, steps), 0.0f);
+	check("trace_parallel (simd) vs trace (simd)", max_deviation(parallel_simd, simd, steps), 0.0f);
+	check("evaluate_batch vs evaluate", max_deviation(batch, reference, accurate), 1e-4f * length);
+
+	//math: the camera transform and normalization over a cache resident block of trace points,
+	//scalar reference vs Vector4A
+	const int block = std::min(steps, 4096), rounds = std::max(1, steps / block);
+	Math::Matrix4D camera = Math::Matrix4D::view(Math::Vector3D(1, 0, 0), Math::Vector3D(0, 0.8f, 0.6f), Math::Vector3D(0, 0.6f, -0.8f)) * Math::Matrix4D::translate(Math::Vector3D(0.5f, 2.0f, -1.0f));
+	std::vector<Math::Vector4D> transformed_scalar(block);
+	std::vector<Math::Vector4A> points(block), transformed(block), normalized(block);
+	std::vector<Math::Vector3D> normalized_scalar(block);
+	for (int i = 0; i < block; ++i)
+		points[i] = Math::Vector4A(simd[i], 1.0f);
+
+	benchmark("transform (scalar)", block * rounds, [&]() {
+		for (int n = 0; n < rounds; ++n)
+			for (int i = 0; i < block; ++i) {
+				Math::Vector4D p = points[i].xyzw(), out;
+				for (int r = 0; r < 4; ++r)
+					out[r] = camera[r].dot(p);
+				transformed_scalar[i] = out;
+			}
+	});
+	benchmark("transform (Vector4A)", block * rounds, [&]() {
+		for (int n = 0; n < rounds; ++n)
+			for (int i = 0; i < block; ++i)
+				transformed[i] = camera * points[i];
+	});
+	benchmark("normalize (scalar)", block * rounds, [&]() {
+		for (int n = 0; n < rounds; ++n)
+			for (int i = 0; i < block; ++i) {
+				float l = simd[i].length();
+				normalized_scalar[i] = Math::Vector3D(simd[i][0] / l, simd[i][1] / l, simd[i][2] / l);
+			}
+	});
+	benchmark("normalize (Vector4A)", block * rounds, [&]() {
+		for (int n = 0; n < rounds; ++n)
+			for (int i = 0; i < block; ++i)
+				normalized[i] = Math::Vector4A(simd[i]).normalize();
+	});
+
+	Math::Matrix4D step = Math::Matrix4D(Math::Vector4D(0.6f, -0.8f, 0, 0), Math::Vector4D(0.8f, 0.6f, 0, 0), Math::Vector4D(0, 0, 1, 0), Math::Vector4D(0, 0, 0, 1));
+	auto multiply_scalar = [](const Math::Matrix4D &a, const Math::Matrix4D &b) {
+		Math::Matrix4D out;
+		for (int i = 0; i < 4; ++i)
+			for (int j = 0; j < 4; ++j) {
+				float sum = 0.0f;
+				for (int k = 0; k < 4; ++k)
+					sum += a(i, k) * b(k, j);
+				out(i, j) = sum;
+			}
+		return out;
+	};
+	Math::Matrix4D product_scalar = camera, product = camera;
+	int products = std::max(1, steps / 16);
+	benchmark("4x4 products (scalar)", products, [&]() {
+		for (int n = 0; n < products; ++n)
+			product_scalar = multiply_scalar(product_scalar, step);
+	});
+	benchmark("4x4 products (Matrix4D)", products, [&]() {
+		for (int n = 0; n < products; ++n)
+			product = product * step;
+	});
+
+	float transform_deviation = 0.0f, normalize_deviation = 0.0f, product_deviation = 0.0f;
+	for (int i = 0; i < block; ++i) {
+		transform_deviation = std::max(transform_deviation, transformed[i].xyzw().distance_from(transformed_scalar[i]));
+		normalize_deviation = std::max(normalize_deviation, normalized[i].xyz().distance_from(normalized_scalar[i]));
+	}
+	Math::Matrix4D single = camera * step, single_scalar = multiply_scalar(camera, step);
+	for (int i = 0; i < 4; ++i)
+		product_deviation = std::max(product_deviation, single.columns[i].distance_from(single_scalar.columns[i]));
+	check("transform (Vector4A) vs scalar", transform_deviation, 1e-6f);
+	check("normalize (Vector4A) vs division", normalize_deviation, 1e-6f);
+	check("4x4 product (Matrix4D) vs scalar", product_deviation, 1e-6f);
+
+	//array kernels over the whole trace, against plain loops over Vector3D
+	Math::Vector3D origin(0.1f, -0.2f, 0.3f);
+	std::vector<float> distances(steps), distances_reference(steps), sx(steps), sy(steps), sz(steps), sx_out(steps), sy_out(steps), sz_out(steps);
+	std::vector<Math::Vector3D> moved(steps), moved_reference(steps);
+	for (int i = 0; i < steps; ++i) {
+		sx[i] = simd[i][0];
+		sy[i] = simd[i][1];
+		sz[i] = simd[i][2];
+	}
+	int within = 0, within_reference = 0, farthest_index = 0, farthest_reference = 0;
+	Math::Vector3D center, center_reference;
+
+	benchmark("transform loop", steps, [&]() {
+		for (int i = 0; i < steps; ++i) {
+			Math::Vector4D p = camera * Math::Vector4D(simd[i][0], simd[i][1], simd[i][2], 1.0f);
+			moved_reference[i].set(p[0], p[1], p[2]);
+		}
+	});
+	benchmark("transform_points", steps, [&]() {Math::transform_points(camera, simd.data(), steps, moved.data());});
+	benchmark("transform_points (soa)", steps, [&]() {Math::transform_points(camera, sx.data(), sy.data(), sz.data(), steps, sx_out.data(), sy_out.data(), sz_out.data());});
+	benchmark("transform_points (threads)", steps, [&]() {Math::transform_points(camera, simd.data(), steps, moved.data(), 0);});
+	benchmark("distance loop", steps, [&]() {
+		for (int i = 0; i < steps; ++i)
+			distances_reference[i] = simd[i].distance_from(origin);
+	});
+	benchmark("distances_to", steps, [&]() {Math::distances_to(origin, simd.data(), steps, distances.data());});
+	benchmark("distances_to (soa)", steps, [&]() {Math::distances_to(origin, sx.data(), sy.data(), sz.data(), steps, distances.data());});
+	benchmark("radius count loop", steps, [&]() {
+		for (int i = 0; i < steps; ++i)
+			within_reference += simd[i].distance_from(origin) <= 1.0f;
+	});
+	benchmark("count_within_radius", steps, [&]() {within = Math::count_within_radius(origin, simd.data(), steps, 1.0f);});
+	benchmark("argmax loop", steps, [&]() {
+		float max_distance = -1.0f;
+		for (int i = 0; i < steps; ++i) {
+			float d = simd[i].distance_from(origin);
+			if (d > max_distance) {
+				max_distance = d;
+				farthest_reference = i;
+			}
+		}
+	});
+	benchmark("argmax_distance", steps, [&]() {farthest_index = Math::argmax_distance(origin, simd.data(), steps);});
+	benchmark("centroid loop", steps, [&]() {
+		for (int i = 0; i < steps; ++i)
+			center_reference += simd[i];
+		center_reference = center_reference * (1.0f / steps);
+	});
+	benchmark("centroid", steps, [&]() {center = Math::centroid(simd.data(), steps);});
+
+	float moved_deviation = 0.0f, distance_deviation = 0.0f;
+	for (int i = 0; i < steps; ++i) {
+		moved_deviation = std::max(moved_deviation, moved[i].distance_from(moved_reference[i]));
+		moved_deviation = std::max(moved_deviation, moved[i].distance_from(Math::Vector3D(sx_out[i], sy_out[i], sz_out[i])));
+		distance_deviation = std::max(distance_deviation, std::abs(distances[i] - distances_reference[i]));
+	}
+	double exact[3] = {0.0, 0.0, 0.0};
+	for (int i = 0; i < steps; ++i)
+		for (int c = 0; c < 3; ++c)
+			exact[c] += simd[i][c];
+	Math::Vector3D exact_center(exact[0] / steps, exact[1] / steps, exact[2] / steps);
+	check("transform_points vs loop", moved_deviation, 1e-6f * length);
+	check("distances_to vs loop", distance_deviation, 1e-6f * length);
+	check("count_within_radius vs loop", std::abs(within - within_reference), 0.0f);
+	check("argmax_distance vs loop", simd[farthest_index].distance_from(origin) - simd[farthest_reference].distance_from(origin), 0.0f);
+	check("argmax_distance (threads) vs single", std::abs(Math::argmax_distance(origin, simd.data(), steps, 0) - farthest_index), 0.0f);
+	std::vector<Math::Vector3D> nans(7, Math::Vector3D(NAN, NAN, NAN));
+	check("argmax_distance of NaN points", std::abs(Math::argmax_distance(origin, nans.data(), nans.size())), 0.0f);
+	//NaNs around the farthest point, in every lane of the sse groups and in the scalar tail
+	std::vector<Math::Vector3D> mixed(23, Math::Vector3D(1.0f, 0.0f, 0.0f));
+	for (int i = 1; i < mixed.size(); i += 2)
+		mixed[i] = Math::Vector3D(NAN, NAN, NAN);
+	for (int farthest_mixed : {0, 6, 12, 22}) {
+		mixed[farthest_mixed] = Math::Vector3D(5.0f, 0.0f, 0.0f);
+		check("argmax_distance among NaN points", std::abs(Math::argmax_distance(Math::Vector3D(), mixed.data(), mixed.size()) - farthest_mixed), 0.0f);
+		mixed[farthest_mixed] = Math::Vector3D(1.0f, 0.0f, 0.0f);
+	}
+	check("centroid vs double sum", center.distance_from(exact_center), 1e-6f * length);
+	check("centroid (threads) vs double sum", Math::centroid(simd.data(), steps, 0).distance_from(exact_center), 1e-6f * length);
+	print("centroid loop error:", center_reference.distance_from(exact_center));
+
+	//thinning
+	float point_r = 0.09f;
+	std::vector<Math::Vector3D> thinned;
+	benchmark("thin_points", steps, [&]() {thinned = Geometry::thin_points(simd, point_r);});
+	print("kept points:", thinned.size());
+
+	float closest = point_r;
+	for (int i = 0; i < thinned.size(); ++i)
+		for (int j = i + 1; j < thinned.size(); ++j)
+			closest = std::min(closest, thinned[i].distance_from(thinned[j]));
+	check("thin_points spacing", point_r - closest, 0.0f);
+
+	float farthest = 0.0f;
+	for (int i = 0; i < steps; i += 97) {
+		float nearest = thinned[0].distance_from(simd[i]);
+		for (const Math::Vector3D &p : thinned)
+			nearest = std::min(nearest, p.distance_from(simd[i]));
+		farthest = std::max(farthest, nearest);
+	}
+	check("thin_points coverage", farthest, point_r);
+
+	//copies of a point in the 27 cells around it, also on cell boundaries, are each seen once around it
+	int misplaced = 0;
+	Geometry::PointGrid boundary_grid(2.0f * point_r);
+	for (int i = 0; i < 100; ++i) {
+		Math::Vector3D p = Math::Vector3D(i, -i, 3 * i) * (2.0f * point_r);
+		for (int c = 0; c < 27; ++c)
+			boundary_grid.insert_offset(p, c % 3 - 1, c / 3 % 3 - 1, c / 9 - 1, i * 27 + c);
+		std::vector<int> seen(27, 0);
+		boundary_grid.for_each_nearby(p, [&](int id) {
+			if (id / 27 == i) seen[id % 27]++;
+			return true;
+		});
+		for (int c = 0; c < 27; ++c)
+			if (seen[c] != 1) misplaced++;
+	}
+	check("PointGrid::insert_offset on cell boundaries", misplaced, 0.0f);
+
+	//dimension: a closed curve, a sphere and a cube against the trace
+	std::vector<Math::Vector3D> curve(steps), sphere(steps), cube(steps);
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+	for (int i = 0; i < steps; ++i) {
+		float t = 6.2832f * i / steps;
+		curve[i].set(cos(t), sin(t), 0.3f * sin(3.0f * t));
+		Math::Vector3D p(uniform(random), uniform(random), uniform(random));
+		cube[i] = p;
+		sphere[i] = p.normalize();
+	}
+	float trace_dimension = 0.0f;
+	benchmark("intrinsic_dimension", steps, [&]() {trace_dimension = Geometry::intrinsic_dimension(simd, point_r);});
+	print("trace dimension:", trace_dimension, "surface likelihood:", Geometry::surface_likelihood(trace_dimension));
+	check("intrinsic_dimension of a curve", std::abs(Geometry::intrinsic_dimension(curve, point_r) - 1.0f), 0.15f);
+	check("intrinsic_dimension of a sphere", std::abs(Geometry::intrinsic_dimension(sphere, point_r) - 2.0f), 0.15f);
+	check("intrinsic_dimension of a cube", std::abs(Geometry::intrinsic_dimension(cube, point_r) - 3.0f), 0.15f);
+
+	//neighbours
+	float radius = 3.5f * point_r;
+	Geometry::Adjacency adjacency;
+	benchmark("radius_neighbours", thinned.size(), [&]() {adjacency = Geometry::radius_neighbours(thinned, radius);});
+	print("neighbours:", adjacency.indices.size(), "(" + std::to_string(adjacency.indices.size() * sizeof(uint32_t) / 1024) + " KB)");
+
+	int wrong_neighbours = 0;
+	for (int i = 0; i < thinned.size(); ++i) {
+		std::vector<uint32_t> expected, found(adjacency.begin(i), adjacency.end(i));
+		for (int j = 0; j < thinned.size(); ++j)
+			if (j != i && thinned[i].distance_from(thinned[j]) <= radius)
+				expected.push_back(j);
+		std::sort(found.begin(), found.end());
+		if (found != expected) wrong_neighbours++;
+	}
+	check("radius_neighbours vs brute force", wrong_neighbours, 0.0f);
+
+	int wrong_common = 0;
+	std::vector<uint32_t> common;
+	benchmark("common_neighbours", adjacency.indices.size(), [&]() {
+		for (int a = 0; a < thinned.size(); ++a)
+			for (const uint32_t *b = adjacency.begin(a); b != adjacency.end(a); ++b)
+				Geometry::common_neighbours(adjacency, a, *b, common);
+	});
+	for (int a = 0; a < thinned.size(); a += 7)
+		for (const uint32_t *b = adjacency.begin(a); b != adjacency.end(a); ++b) {
+			std::vector<uint32_t> expected;
+			for (const uint32_t *i = adjacency.begin(a); i != adjacency.end(a); ++i)
+				for (const uint32_t *j = adjacency.begin(*b); j != adjacency.end(*b); ++j)
+					if (*i == *j) expected.push_back(*i);
+			Geometry::common_neighbours(adjacency, a, *b, common);
+			if (common != expected) wrong_common++;
+		}
+	check("common_neighbours vs nested loops", wrong_common, 0.0f);
+
+	//edge structures, used the way the surface growth uses them: every edge is looked up in the
+	//cache and closed with its first acceptable common neighbour, one generation per 64 points
+	Geometry::EdgeNeighbourCache edge_neighbours;
+	Geometry::EdgeMesh edges;
+	int triangles = 0;
+	edge_neighbours.init(adjacency);
+	benchmark("edge growth", adjacency.indices.size(), [&]() {
+		for (int a = 0; a < thinned.size(); ++a) {
+			for (const uint32_t *b = adjacency.begin(a); b != adjacency.end(a); ++b)
+				for (uint32_t c : edge_neighbours.get(a, *b))
+					if (edges.add_triangle(a, *b, c, triangles)) {
+						triangles++;
+						break;
+					}
+			if (a % 64 == 63) edge_neighbours.next_generation();
+		}
+	});
+	print("triangles:", triangles);
+
+	int over_shared = 0;
+	for (int a = 0; a < thinned.size(); ++a)
+		for (const uint32_t *b = adjacency.begin(a); b != adjacency.end(a); ++b)
+			if (edges.triangle_count(a, *b) > 2) over_shared++;
+	check("edge growth stays manifold", over_shared, 0.0f);
+
+	//the whole surface pipeline, headless, with the parameters of spiro_3d_v5
+	SurfacePipeline::Parameters parameters;
+	parameters.structure = structure;
+	parameters.steps = 50000;
+	parameters.step_delta = step_delta;
+	parameters.point_r = point_r;
+	SurfacePipeline pipeline(parameters);
+	int growth_steps = 0;
+	benchmark("pipeline generate", parameters.steps, [&]() {pipeline.generate();});
+	benchmark("pipeline trim", parameters.steps, [&]() {pipeline.trim();});
+	benchmark("pipeline create_surface", pipeline.trimmed().size(), [&]() {pipeline.create_surface();});
+	benchmark("pipeline grow", pipeline.trimmed().size(), [&]() {
+		while (!pipeline.frontier().empty() && growth_steps < 1000) {
+			pipeline.grow();
+			growth_steps++;
+		}
+	});
+	print("surface triangles:", pipeline.triangles().size(), "growth steps:", growth_steps);
+
+	Geometry::EdgeTable<int> surface_edges;
+	over_shared = 0;
+	for (const SurfacePipeline::Triangle *triangle : pipeline.triangles())
+		for (int i = 0; i < 3; ++i) {
+			uint64_t key = Geometry::EdgeTable<int>::key(triangle->v[i]->index(), triangle->v[(i + 1) % 3]->index());
+			const int *found = surface_edges.find(key);
+			int count = found == nullptr ? 1 : *found + 1;
+			surface_edges.insert(key, count);
+			if (count > 2) over_shared++;
+		}
+	check("pipeline surface stays manifold", over_shared, 0.0f);
+
+	//a trace that closes after one turn is a curve, the classifier has to skip its surface.
+	//the small step keeps the one period trace dense enough to estimate at point_r
+	SurfacePipeline::Parameters closed_parameters = parameters;
+	closed_parameters.structure.clear();
+	closed_parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.0f, 0.0f), 1.0f});
+	closed_parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(2.0f, 0.0f, 0.0f), 0.5f});
+	closed_parameters.step_delta = 0.01f;
+	closed_parameters.min_surface_likelihood = 0.1f;
+	SurfacePipeline closed(closed_parameters);
+	closed.run(1000);
+	print("closed curve dimension:", closed.dimension(), "surface likelihood:", closed.surface_likelihood());
+	check("closed curve dimension", std::abs(closed.dimension() - 1.0f), 0.15f);
+	check("closed curve skipped", closed.triangles().size() + closed.trimmed().size(), 0.0f);
+
+	//a closed trace that winds densely (a torus knot, 101 turns around the tube per period) covers a
+	//surface at point_r, it has to be meshed even though it is capped at a period
+	SurfacePipeline::Parameters knot_parameters = parameters;
+	knot_parameters.structure.clear();
+	knot_parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0f, 1.0f), 1.0f});
+	knot_parameters.structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 1.01f, 0.0f), 0.5f});
+	knot_parameters.step_delta = 0.05f;
+	knot_parameters.min_surface_likelihood = 0.5f;
+	SurfacePipeline knot(knot_parameters);
+	knot.run(1000);
+	print("torus knot period:", knot.period(), "traced steps:", knot.trace().size(), "dimension:", knot.dimension(), "triangles:", knot.triangles().size());
+	check("torus knot capped at a period", knot.period() < 0.0f ? 1.0f : 0.0f, 0.0f);
+	check("torus knot dimension", std::abs(knot.dimension() - 2.0f), 0.3f);
+	check("torus knot meshed", knot.triangles().empty() ? 1.0f : 0.0f, 0.0f);
+
+	//the same curve is only traced for one period, and the rest of a full trace retraces it
+	float two_pi = 6.2831853f;
+	check("period of speeds 1, 2", std::abs(Spirograph::period(closed_parameters.structure, 1000.0f) - two_pi), 1e-5f * two_pi);
+	Spirograph::Structure stub_structure = closed_parameters.structure;
+	stub_structure.emplace_back(std::tuple<Math::Vector3D, float>{Math::Vector3D(0.0f, 0.0117f, 0.0f), 0.0f});
+	check("period ignores a last handle without length", std::abs(Spirograph::period(stub_structure, 1000.0f) - two_pi), 1e-5f * two_pi);
+	check("no period of spiro_3d_v5 within 5000", Spirograph::period(structure, 5000.0f) == -1.0f ? 0.0f : 1.0f, 0.0f);
+	//117 turns of the slowest handle. the float speeds are a little off 0.0117 * n / 117, so the curve
+	//drifts about 0.011 per period
+	float preset_period = two_pi * 117.0f / 0.0117f;
+	check("period of spiro_3d_v5", std::abs(Spirograph::period(structure, 1e5f, 0.05f) - preset_period), 1e-4f * preset_period);
+	int period_steps = (int) ceil(two_pi / closed_parameters.step_delta) + 1;
+	print("closed curve period:", closed.period(), "traced steps:", closed.trace().size(), "of", closed_parameters.steps);
+	check("trace capped at one period", std::abs((int) closed.trace().size() - period_steps), 0.0f);
+	std::vector<Math::Vector3D> full_trace = Spirograph::trace(closed_parameters.structure, closed_parameters.start_time, closed_parameters.step_delta, closed_parameters.steps);
+	float off_curve = 0.0f;
+	for (const Math::Vector3D &p : full_trace) {
+		float nearest = p.distance_from(closed.trace()[0]);
+		for (const Math::Vector3D &q : closed.trace())
+			nearest = std::min(nearest, p.distance_from(q));
+		off_curve = std::max(off_curve, nearest);
+	}
+	//every sample is within half a step (at most 2.5 * 0.01 long) of the capped trace
+	check("one period covers the full trace", off_curve, 0.5f * 2.5f * 0.01f);
+	closed.parameters = parameters;
+	closed.parameters.min_surface_likelihood = 0.1f;
+	closed.run(1000);
+	check("spiro_3d_v5 surface not skipped", closed.triangles().empty() ? 1.0f : 0.0f, 0.0f);
+
+	//independent pipelines on separate threads have to build the same surfaces as one after the other
+	const int instances = 4;
+	auto surface_key = [](const SurfacePipeline &p) {
+		uint64_t key = p.triangles().size();
+		for (const SurfacePipeline::Triangle *triangle : p.triangles())
+			for (int i = 0; i < 3; ++i)
+				key = key * 31 + triangle->v[i]->index();
+		return key;
+	};
+	std::vector<uint64_t> sequential_keys(instances), concurrent_keys(instances);
+	auto instance_parameters = [&](int i) {
+		SurfacePipeline::Parameters p = parameters;
+		p.point_r = point_r * (1.0f + 0.1f * i);
+		p.threads = 1;
+		return p;
+	};
+	benchmark("pipelines (sequential)", instances * parameters.steps, [&]() {
+		for (int i = 0; i < instances; ++i) {
+			SurfacePipeline p(instance_parameters(i));
+			p.run(1000);
+			sequential_keys[i] = surface_key(p);
+		}
+	});
+	benchmark("pipelines (threads)", instances * parameters.steps, [&]() {
+		std::vector<std::thread> workers;
+		for (int i = 0; i < instances; ++i)
+			workers.emplace_back([&, i]() {
+				SurfacePipeline p(instance_parameters(i));
+				p.run(1000);
+				concurrent_keys[i] = surface_key(p);
+			});
+		for (std::thread &worker : workers)
+			worker.join();
+	});
+	int different_surfaces = 0;
+	for (int i = 0; i < instances; ++i)
+		if (sequential_keys[i] != concurrent_keys[i]) different_surfaces++;
+	check("concurrent pipelines vs sequential", different_surfaces, 0.0f);
+
+	//a small sweep: work stealing across more workers than cores has to match evaluating every
+	//configuration in order, and the results have to come out ranked
+	Sweep::Ranges ranges;
+	ranges.base = parameters;
+	for (const std::tuple<Math::Vector3D, float> &handle : structure) {
+		Sweep::HandleRange range;
+		for (int c = 0; c < 3; ++c)
+			range.axis[c] = Sweep::Range(std::get<0>(handle)[c]);
+		range.length = Sweep::Range(std::get<1>(handle));
+		ranges.handles.push_back(range);
+	}
+	ranges.handles[1].axis[1] = Sweep::Range(-0.3f, -0.1f, 3);
+	ranges.steps = Sweep::Range(10000);
+	ranges.step_delta = Sweep::Range(step_delta);
+	ranges.point_r = Sweep::Range(0.08f, 0.1f, 3);
+	long configurations = Sweep::configuration_count(ranges);
+	std::vector<Sweep::Result> swept;
+	benchmark("sweep", configurations * ranges.steps.first, [&]() {swept = Sweep::run(ranges, 4);});
+
+	int wrong_results = 0;
+	std::vector<int> evaluated(configurations, 0);
+	for (int i = 0; i < swept.size(); ++i) {
+		if (evaluated[swept[i].configuration]++) wrong_results++;
+		Sweep::Result expected = Sweep::evaluate(Sweep::configuration(ranges, swept[i].configuration), ranges.max_growth_steps);
+		if (expected.triangles != swept[i].triangles || expected.score != swept[i].score) wrong_results++;
+		if (i > 0 && swept[i].score > swept[i - 1].score) wrong_results++;
+	}
+	check("sweep (" + std::to_string(configurations) + " configurations) vs evaluate", wrong_results, 0.0f);
+
+	return failures == 0 ? 0 : 1;
+}
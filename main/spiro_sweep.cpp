@@ -0,0 +1,76 @@
+#include <CREngine/Sweep.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+using namespace CREngine;
+
+template<class T>
+void print(T t) {
+	std::cout<<t<<std::endl;
+}
+
+template<class T, class... Args>
+void print(T t, Args ...args) {
+	std::cout<<t<<" ";
+	print(args...);
+}
+
+/*
+headless parameter sweep around the presets of spiro_3d_v5.
+usage: spiro_sweep [results file] [threads]
+writes every configuration ranked by score to the results file (sweep_results.tsv by default)
+and prints the best few.
+*/
+int main(int argc, char const *argv[]) {
+	const char *path = argc > 1 ? argv[1] : "sweep_results.tsv";
+	int threads = argc > 2 ? atoi(argv[2]) : 0;
+
+	//four handles: two fast ones on x and y, a slow one whose speed is swept and a short wobble.
+	//without the wobble the speeds are multiples of 0.1, so the trace closes into a curve
+	Sweep::Ranges ranges;
+	Sweep::HandleRange handle;
+	handle.axis[0] = Sweep::Range(0.1f, 0.3f, 3);
+	handle.length = Sweep::Range(1.0f);
+	ranges.handles.push_back(handle);
+
+	handle = Sweep::HandleRange();
+	handle.axis[1] = Sweep::Range(-0.3f, -0.1f, 3);
+	handle.length = Sweep::Range(0.5f, 1.0f, 2);
+	ranges.handles.push_back(handle);
+
+	handle = Sweep::HandleRange();
+	handle.axis[1] = Sweep::Range(0.1f, 0.3f, 3);
+	handle.length = Sweep::Range(0.2f);
+	ranges.handles.push_back(handle);
+
+	handle = Sweep::HandleRange();
+	handle.axis[1] = Sweep::Range(0.0117f);
+	handle.axis[2] = Sweep::Range(0.0f, 0.01f, 2);
+	handle.length = Sweep::Range(0.0f, 0.2f, 2);
+	ranges.handles.push_back(handle);
+
+	ranges.steps = Sweep::Range(20000);
+	ranges.step_delta = Sweep::Range(0.1f);
+	ranges.point_r = Sweep::Range(0.07f, 0.11f, 3);
+
+	//don't mesh traces that are far from 2 dimensional
+	ranges.base.min_surface_likelihood = 0.1f;
+
+	print("configurations:", Sweep::configuration_count(ranges));
+	std::vector<Sweep::Result> results = Sweep::run(ranges, threads);
+
+	std::ofstream out(path);
+	if (!out) {
+		std::cerr<<"couldn't open "<<path<<std::endl;
+		return 1;
+	}
+	Sweep::write_table(out, results);
+	print("results written to", path);
+
+	std::vector<Sweep::Result> best(results.begin(), results.begin() + std::min((int) results.size(), 5));
+	Sweep::write_table(std::cout, best);
+	return 0;
+}
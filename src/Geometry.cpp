@@ -0,0 +1,305 @@
+#include <CREngine/Geometry.h>
+
+#include <algorithm>
+
+using namespace CREngine;
+using namespace CREngine::Math;
+using namespace CREngine::Geometry;
+
+//PointGrid
+PointGrid::PointGrid(float cell_size, int expected_points) : inverse_cell_size(1.0f / cell_size), used_slots(0) {
+	int size = 64;
+	while (size < expected_points * 2) size *= 2;
+	slots.assign(size, Slot{0, -1});
+	next.reserve(expected_points);
+}
+
+uint64_t PointGrid::cell_key(int x, int y, int z) {
+	//21 bits per axis, enough for +-1M cells
+	const uint64_t mask = (1 << 21) - 1;
+	return (((uint64_t) (x + (1 << 20)) & mask) << 42) | (((uint64_t) (y + (1 << 20)) & mask) << 21) | ((uint64_t) (z + (1 << 20)) & mask);
+}
+
+int PointGrid::find_slot(uint64_t key) const {
+	uint64_t mask = slots.size() - 1;
+	uint64_t i = (key * 0x9E3779B97F4A7C15ull) >> 32 & mask;
+	while (slots[i].head != -1 && slots[i].key != key)
+		i = (i + 1) & mask;
+	return i;
+}
+
+void PointGrid::grow() {
+	std::vector<Slot> old;
+	old.swap(slots);
+	slots.assign(old.size() * 2, Slot{0, -1});
+	for (const Slot &slot : old)
+		if (slot.head != -1)
+			slots[find_slot(slot.key)] = slot;
+}
+
+void PointGrid::insert(const Vector3D &position, int id) {
+	insert_offset(position, 0, 0, 0, id);
+}
+
+void PointGrid::insert_offset(const Vector3D &position, int dx, int dy, int dz, int id) {
+	if (id >= next.size()) next.resize(id + 1, -1);
+
+	uint64_t key = cell_key((int) floor(position[0] * inverse_cell_size) + dx, (int) floor(position[1] * inverse_cell_size) + dy, (int) floor(position[2] * inverse_cell_size) + dz);
+	int slot = find_slot(key);
+	if (slots[slot].head == -1) {
+		//keep the table at most half full
+		if ((used_slots + 1) * 2 > slots.size()) {
+			grow();
+			slot = find_slot(key);
+		}
+		used_slots++;
+		slots[slot].key = key;
+	}
+
+	next[id] = slots[slot].head;
+	slots[slot].head = id;
+}
+
+//thinning
+std::vector<Vector3D> Geometry::thin_points(const std::vector<Vector3D> &points, float min_distance) {
+	std::vector<Vector3D> kept;
+	PointGrid grid(min_distance);
+
+	for (const Vector3D &point : points) {
+		bool isolated = true;
+		grid.for_each_nearby(point, [&](int id) {
+			if (point.distance_from(kept[id]) < min_distance) isolated = false;
+			return isolated;
+		});
+
+		if (isolated) {
+			grid.insert(point, kept.size());
+			kept.push_back(point);
+		}
+	}
+	return kept;
+}
+
+//dimension
+float Geometry::intrinsic_dimension(const std::vector<Vector3D> &points, float radius) {
+	const int QUERIES = 256;
+	const int MIN_NEAR_PAIRS = QUERIES;		//one per query on average
+	if (points.size() < 2 || radius <= 0.0f) return -1.0f;
+
+	//the mean distance between consecutive points, from up to 1024 pairs spread over the points
+	int pairs = std::min((int) points.size() - 1, 1024);
+	float spacing = 0.0f;
+	for (int k = 0; k < pairs; ++k) {
+		int i = (long) k * (points.size() - 1) / pairs;
+		spacing += points[i].distance_from(points[i + 1]);
+	}
+	spacing /= pairs;
+
+	//consecutive sampled points are about radius / 4 apart along a trace, however long it is.
+	//one point from every stride, at a jittered offset. a fixed offset can alias with the period
+	//of a trace and sample the same few spots of every loop
+	int stride = spacing > 0.0f ? (int) std::min(0.25f * radius / spacing, (float) points.size()) : 1;
+	if (stride < 1) stride = 1;
+	int samples = (points.size() + stride - 1) / stride;
+	int last = points.size() - 1;
+	auto sample = [&](int k) {
+		if (stride == 1) return k;
+		float golden = k * 0.6180339887f;
+		return std::min(k * stride + (int) ((golden - (int) golden) * stride), last);
+	};
+
+	//evenly spread query points. each one is added to the 27 cells around it, so a sample only
+	//looks up its own cell to find the queries within 2 * radius
+	int query_stride = std::max(1, samples / QUERIES);
+	std::vector<int> queries;			//sample numbers
+	std::vector<Vector3D> query_points;
+	for (int k = 0; k < samples; k += query_stride) {
+		queries.push_back(k);
+		query_points.push_back(points[sample(k)]);
+	}
+	PointGrid grid(2.0f * radius, queries.size() * 27);
+	for (int q = 0; q < queries.size(); ++q)
+		for (int c = 0; c < 27; ++c)
+			grid.insert_offset(query_points[q], c % 3 - 1, c / 3 % 3 - 1, c / 9 - 1, q * 27 + c);
+
+	//pair counts around the query points
+	long near = 0, far = 0;
+	float squared_radius = radius * radius;
+	for (int k = 0; k < samples; ++k) {
+		const Vector3D &p = points[sample(k)];
+		grid.for_each_in_cell(p, [&](int id) {
+			int q = id / 27;
+			if (queries[q] == k) return true;
+			Vector3D d = query_points[q] - p;
+			float squared_distance = d.dot(d);
+			if (squared_distance <= squared_radius) near++;
+			if (squared_distance <= 4.0f * squared_radius) far++;
+			return true;
+		});
+	}
+
+	//too few pairs to tell, the points are sparse at this scale
+	if (near < MIN_NEAR_PAIRS) return -1.0f;
+	return std::min(std::max((float) log2((float) far / near), 0.0f), 3.0f);
+}
+
+float Geometry::surface_likelihood(float dimension) {
+	if (dimension < 0.0f) return 0.0f;
+	float d = (dimension - 2.0f) * 2.0f;
+	return exp(-d * d);
+}
+
+//neighbours
+Adjacency Geometry::radius_neighbours(const std::vector<Vector3D> &points, float radius) {
+	PointGrid grid(radius, points.size());
+	for (int i = 0; i < points.size(); ++i)
+		grid.insert(points[i], i);
+
+	Adjacency adjacency;
+	adjacency.offsets.resize(points.size() + 1);
+	adjacency.indices.reserve(points.size() * 16);
+	for (int i = 0; i < points.size(); ++i) {
+		adjacency.offsets[i] = adjacency.indices.size();
+		grid.for_each_nearby(points[i], [&](int j) {
+			if (j != i && points[i].distance_from(points[j]) <= radius)
+				adjacency.indices.push_back(j);
+			return true;
+		});
+		std::sort(adjacency.indices.begin() + adjacency.offsets[i], adjacency.indices.end());
+	}
+	adjacency.offsets[points.size()] = adjacency.indices.size();
+	adjacency.indices.shrink_to_fit();
+	return adjacency;
+}
+
+void Geometry::common_neighbours(const Adjacency &adjacency, int a, int b, std::vector<uint32_t> &out) {
+	const uint32_t *i_a = adjacency.begin(a), *end_a = adjacency.end(a);
+	const uint32_t *i_b = adjacency.begin(b), *end_b = adjacency.end(b);
+	out.clear();
+
+	//make a the shorter list
+	if (end_a - i_a > end_b - i_b) {
+		std::swap(i_a, i_b);
+		std::swap(end_a, end_b);
+	}
+
+	if ((end_b - i_b) > 8 * (end_a - i_a)) {
+		//gallop: binary search every element of the short list in the rest of the long one
+		for (; i_a != end_a && i_b != end_b; ++i_a) {
+			i_b = std::lower_bound(i_b, end_b, *i_a);
+			if (i_b != end_b && *i_b == *i_a) out.push_back(*i_a);
+		}
+		return;
+	}
+
+	while (i_a != end_a && i_b != end_b) {
+		if (*i_a < *i_b) ++i_a;
+		else if (*i_b < *i_a) ++i_b;
+		else {
+			out.push_back(*i_a);
+			++i_a;
+			++i_b;
+		}
+	}
+}
+
+//EdgeNeighbourCache
+void EdgeNeighbourCache::Generation::clear() {
+	entries.clear();
+	indices.clear();
+}
+
+EdgeNeighbourCache::EdgeNeighbourCache() : adjacency(nullptr), current(0) {}
+
+void EdgeNeighbourCache::init(const Adjacency &adjacency) {
+	this->adjacency = &adjacency;
+	clear();
+}
+
+IndexRange EdgeNeighbourCache::get(int a, int b) {
+	uint64_t key = EdgeTable<Entry>::key(a, b);
+	Generation &now = generations[current];
+
+	const Entry *entry = now.entries.find(key);
+	if (entry == nullptr) {
+		const Generation &before = generations[1 - current];
+		const Entry *old = before.entries.find(key);
+		Entry added = {(uint32_t) now.indices.size(), 0};
+		if (old != nullptr) {
+			now.indices.insert(now.indices.end(), before.indices.begin() + old->offset, before.indices.begin() + old->offset + old->count);
+		} else {
+			common_neighbours(*adjacency, a, b, scratch);
+			now.indices.insert(now.indices.end(), scratch.begin(), scratch.end());
+		}
+		added.count = now.indices.size() - added.offset;
+		now.entries.insert(key, added);
+		entry = now.entries.find(key);
+	}
+
+	const uint32_t *first = now.indices.data() + entry->offset;
+	return IndexRange{first, first + entry->count};
+}
+
+void EdgeNeighbourCache::next_generation() {
+	current = 1 - current;
+	generations[current].clear();
+}
+
+void EdgeNeighbourCache::clear() {
+	generations[0].clear();
+	generations[1].clear();
+	current = 0;
+}
+
+//EdgeMesh
+const EdgeMesh::Edge *EdgeMesh::find(int a, int b) const {
+	return edges.find(EdgeTable<Edge>::key(a, b));
+}
+
+bool EdgeMesh::can_add_triangle(int a, int b, int c) const {
+	if (a == b || b == c || c == a) return false;
+
+	int corners[3] = {a, b, c};
+	for (int i = 0; i < 3; ++i) {
+		const Edge *edge = find(corners[i], corners[(i + 1) % 3]);
+		if (edge == nullptr) continue;
+		if (edge->triangles[1] != -1) return false;					//the edge already has two triangles
+		if (edge->opposite[0] == corners[(i + 2) % 3]) return false;	//the same triangle already exists
+	}
+	return true;
+}
+
+bool EdgeMesh::add_triangle(int a, int b, int c, int id) {
+	if (!can_add_triangle(a, b, c)) return false;
+
+	int corners[3] = {a, b, c};
+	for (int i = 0; i < 3; ++i) {
+		uint64_t key = EdgeTable<Edge>::key(corners[i], corners[(i + 1) % 3]);
+		Edge *edge = edges.find(key);
+		if (edge == nullptr) {
+			edges.insert(key, Edge{{id, -1}, {corners[(i + 2) % 3], -1}});
+		} else {
+			edge->triangles[1] = id;
+			edge->opposite[1] = corners[(i + 2) % 3];
+		}
+	}
+	return true;
+}
+
+int EdgeMesh::triangle_count(int a, int b) const {
+	const Edge *edge = find(a, b);
+	if (edge == nullptr) return 0;
+	return edge->triangles[1] == -1 ? 1 : 2;
+}
+
+int EdgeMesh::other_triangle(int a, int b, int id) const {
+	const Edge *edge = find(a, b);
+	if (edge == nullptr) return -1;
+	if (edge->triangles[0] == id) return edge->triangles[1];
+	if (edge->triangles[1] == id) return edge->triangles[0];
+	return -1;
+}
+
+void EdgeMesh::clear() {
+	edges.clear();
+}
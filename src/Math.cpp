@@ -1,24 +1,14 @@
 #include <CREngine/Math.h>
 
+#include <algorithm>
 #include <iostream>
+#include <thread>
+#include <vector>
 
+using namespace CREngine;
 using namespace CREngine::Math;
 
 //Vector2D
-Vector2D::Vector2D() : v{0, 0} {}
-
-Vector2D::Vector2D(float x, float y) : v{x, y} {}
-
-Vector2D::Vector2D(const Vector2D &vec) : v{vec.v[0], vec.v[1]} {}
-
-Vector2D Vector2D::operator=(const Vector2D &vec) {
-	if (&vec != this) {
-		v[0] = vec.v[0];
-		v[1] = vec.v[1];
-	}
-	return *this;
-}
-
 float Vector2D::get_angle() {
 	/*
 	using the dot product: let u = <1, 0>
@@ -41,21 +31,6 @@ void Vector2D::print() {
 }
 
 //Vector3D
-Vector3D::Vector3D() : v{0, 0, 0} {};
-
-Vector3D::Vector3D(float x, float y, float z) : v{x, y, z} {};
-
-Vector3D::Vector3D(const Vector3D &vec) : v{vec.v[0], vec.v[1], vec.v[2]} {}
-
-Vector3D Vector3D::operator=(const Vector3D &vec) {
-	if (&vec != this) {
-		v[0] = vec.v[0];
-		v[1] = vec.v[1];
-		v[2] = vec.v[2];
-	}
-	return *this;
-}
-
 std::string Vector3D::to_string() {
 	return "<" + std::to_string(v[0]) + ", " + std::to_string(v[1]) + ", " + std::to_string(v[2]) + ">";
 }
@@ -65,22 +40,6 @@ void Vector3D::print() {
 }
 
 //Vector4D
-Vector4D::Vector4D() : Vector4D(0.0f, 0.0f, 0.0f, 0.0f) {}
-
-Vector4D::Vector4D(float x, float y, float z, float w) : v{x, y, z, w} {}
-
-Vector4D::Vector4D(const Vector4D &vec) : v{vec.v[0], vec.v[1], vec.v[2], vec.v[3]} {}
-
-Vector4D Vector4D::operator=(const Vector4D &vec) {
-	if (&vec != this) {
-		v[0] = vec.v[0];
-		v[1] = vec.v[1];
-		v[2] = vec.v[2];
-		v[3] = vec.v[3];
-	}
-	return *this;
-}
-
 std::string Vector4D::to_string() {
 	return "<" + std::to_string(v[0]) + ", " + std::to_string(v[1]) + ", " + std::to_string(v[2]) + ", " + std::to_string(v[3]) + ">";
 }
@@ -90,10 +49,6 @@ void Vector4D::print() {
 }
 
 //Matrix2D
-Matrix2D::Matrix2D(float a, float b, float c, float d) : rows{Vector2D(a, b), Vector2D(c, d)} {}
-
-Matrix2D::Matrix2D(const Vector2D &row_a, const Vector2D &row_b) : rows{row_a, row_b} {}
-
 //matrix - vector operations
 Vector2D Matrix2D::operator*(const Vector2D &vec) {
 	return Vector2D(rows[0].dot(vec), rows[1].dot(vec));
@@ -117,22 +72,16 @@ Matrix2D Matrix2D::rotation(float theta) {
 
 
 //Matrix3D
-Matrix3D::Matrix3D() {
-
-}
-
-Matrix3D::Matrix3D(const Vector3D &row_a, const Vector3D &row_b, const Vector3D &row_c) : rows{row_a, row_b, row_c} {
-
-}
-
 //matrix - vector operations
 Matrix3D Matrix3D::operator*(float s) const {
-	return Matrix3D(rows[0] * s, rows[1] * s, rows[2] * s);
-	return Matrix3D(rows[0] * s, rows[1] * s, rows[2] * s);
+	Matrix3D out;
+	for (int i = 0; i < 3; ++i)
+		out.columns[i] = columns[i] * s;
+	return out;
 }
 
 Vector3D Matrix3D::operator*(const Vector3D &vec) const {
-	return Vector3D(rows[0].dot(vec), rows[1].dot(vec), rows[2].dot(vec));
+	return columns[0] * vec[0] + columns[1] * vec[1] + columns[2] * vec[2];
 }
 
 Matrix3D Matrix3D::operator*(const Matrix3D &mat) const {
@@ -141,16 +90,19 @@ Matrix3D Matrix3D::operator*(const Matrix3D &mat) const {
 		for (int j = 0; j < 3; ++j) {
 			float sum = 0.0f;
 			for (int k = 0; k < 3; ++k) {
-				sum += rows[i][k] * mat.rows[k][j];
+				sum += columns[k][i] * mat.columns[j][k];
 			}
-			out[i][j] = sum;
+			out.columns[j][i] = sum;
 		}
 	}
 	return out;
 }
 
 Matrix3D Matrix3D::operator+(const Matrix3D &mat) const {
-	return Matrix3D(rows[0] + mat.rows[0], rows[1] + mat.rows[1], rows[2] + mat.rows[2]);
+	Matrix3D out;
+	for (int i = 0; i < 3; ++i)
+		out.columns[i] = columns[i] + mat.columns[i];
+	return out;
 }
 
 //static creators
@@ -162,37 +114,29 @@ Matrix3D Matrix3D::identity() {
 	);
 }
 Matrix3D Matrix3D::rotation(const Vector3D &axis) {
-	Vector3D k = axis.normalize();
+	float theta = axis.length();
+	if (theta == 0.0f) return Matrix3D::identity();	//no direction to normalize
+
+	Vector3D k = axis / theta;
 	Matrix3D K(
 		Vector3D(0.0f, -k[2], k[1]),
 		Vector3D(k[2], 0.0f, -k[0]),
 		Vector3D(-k[1], k[0], 0.0f)
 	);
-	float theta = axis.length();
 	return Matrix3D::identity() + (K * sin(theta)) + ((K * K) * (1 - cos(theta)));
 }
 
 
 //Matrix4D
-Matrix4D::Matrix4D() {}
-
-Matrix4D::Matrix4D(const Vector4D &row_a, const Vector4D &row_b, const Vector4D &row_c, const Vector4D &row_d) : rows{row_a, row_b, row_c, row_d} {}
-
-Vector4D Matrix4D::operator*(const Vector4D &vec) {
-	return Vector4D(rows[0].dot(vec), rows[1].dot(vec), rows[2].dot(vec), rows[3].dot(vec));
+Vector4D Matrix4D::operator*(const Vector4D &vec) const {
+	return (*this * Vector4A(vec)).xyzw();
 }
 
-Matrix4D Matrix4D::operator*(const Matrix4D &mat) {
+Matrix4D Matrix4D::operator*(const Matrix4D &mat) const {
+	//every column of the product is this matrix applied to a column of mat
 	Matrix4D out;
-	for (int i = 0; i < 4; ++i) {
-		for (int j = 0; j < 4; ++j) {
-			float sum = 0.0f;
-			for (int k = 0; k < 4; ++k) {
-				sum += rows[i][k] * mat.rows[k][j];
-			}
-			out[i][j] = sum;
-		}
-	}
+	for (int j = 0; j < 4; ++j)
+		out.columns[j] = (*this * Vector4A(mat.columns[j])).xyzw();
 	return out;
 }
 
@@ -243,3 +187,359 @@ Matrix4D Matrix4D::orthographic_projection(const Vector2D &size, float n, float
 		Vector4D(0.0f, 			0.0f,			0.0f,				1.0f)
 	);
 }
+
+
+//Quaternion
+Matrix3D Quaternion::to_matrix() const {
+	return Matrix3D(
+		Vector3D(1.0f - 2.0f * (y * y + z * z),	2.0f * (x * y - w * z),			2.0f * (x * z + w * y)),
+		Vector3D(2.0f * (x * y + w * z),		1.0f - 2.0f * (x * x + z * z),	2.0f * (y * z - w * x)),
+		Vector3D(2.0f * (x * z - w * y),		2.0f * (y * z + w * x),			1.0f - 2.0f * (x * x + y * y))
+	);
+}
+
+//static creators
+Quaternion Quaternion::axis_angle(const Vector3D &axis, float angle) {
+	float l = axis.length();
+	if (l == 0.0f) return Quaternion();	//no direction to rotate around
+	return half_angle(axis / l, cos(angle * 0.5f), sin(angle * 0.5f));
+}
+
+Quaternion Quaternion::rotation(const Vector3D &axis) {
+	return axis_angle(axis, axis.length());
+}
+
+//array kernels
+//inputs are only split over threads when every thread gets at least this many points
+static const int MIN_POINTS_PER_THREAD = 1 << 15;
+
+//at most this many threads work on one call, so the per range results fit on the stack
+static const int MAX_RANGES = 64;
+
+//points are processed in blocks of this many, small enough for a float partial sum to stay accurate
+static const int KERNEL_BLOCK = 256;
+
+static int range_count(int count, int threads) {
+	if (threads <= 0) threads = std::thread::hardware_concurrency();
+	return std::max(1, std::min(std::min(threads, MAX_RANGES), count / MIN_POINTS_PER_THREAD));
+}
+
+/*
+calls f(range, first, last) for 'ranges' contiguous, equally sized ranges covering [0, count).
+range 0 runs on the calling thread, the others on their own threads.
+*/
+template<class F>
+static void for_each_range(int count, int ranges, const F &f) {
+	auto bounds = [&](int r) {return (int) ((long long) count * r / ranges);};
+	std::vector<std::thread> workers;
+	for (int r = 1; r < ranges; ++r)
+		workers.emplace_back([&, r]() {f(r, bounds(r), bounds(r + 1));});
+	f(0, 0, bounds(1));
+	for (std::thread &w : workers)
+		w.join();
+}
+
+/*
+point sources and sinks for the kernels.
+load() reads 4 points starting at i into x, y, z lanes, get() reads a single point for the tails.
+*/
+struct PackedPoints {
+	const Vector3D *points;
+
+	inline void get(int i, float &x, float &y, float &z) const {x = points[i].v[0]; y = points[i].v[1]; z = points[i].v[2];}
+#ifdef CRENGINE_MATH_SSE
+	inline void load(int i, __m128 &x, __m128 &y, __m128 &z) const {
+		//a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+		const float *p = points[i].v;
+		__m128 a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4), c = _mm_loadu_ps(p + 8);
+		x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+		y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+	}
+#endif
+};
+
+struct PackedOutput {
+	Vector3D *points;
+
+	inline void set(int i, float x, float y, float z) const {points[i].set(x, y, z);}
+#ifdef CRENGINE_MATH_SSE
+	inline void store(int i, __m128 x, __m128 y, __m128 z) const {
+		float *p = points[i].v;
+		__m128 xy_low = _mm_unpacklo_ps(x, y), xy_high = _mm_unpackhi_ps(x, y);
+		_mm_storeu_ps(p, _mm_shuffle_ps(xy_low, _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+		_mm_storeu_ps(p + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), xy_high, _MM_SHUFFLE(1, 0, 2, 0)));
+		_mm_storeu_ps(p + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, xy_high, _MM_SHUFFLE(3, 2, 2, 2)), _mm_shuffle_ps(xy_high, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+#endif
+};
+
+struct SplitPoints {
+	const float *x, *y, *z;
+
+	inline void get(int i, float &px, float &py, float &pz) const {px = x[i]; py = y[i]; pz = z[i];}
+#ifdef CRENGINE_MATH_SSE
+	inline void load(int i, __m128 &px, __m128 &py, __m128 &pz) const {px = _mm_loadu_ps(x + i); py = _mm_loadu_ps(y + i); pz = _mm_loadu_ps(z + i);}
+#endif
+};
+
+struct SplitOutput {
+	float *x, *y, *z;
+
+	inline void set(int i, float px, float py, float pz) const {x[i] = px; y[i] = py; z[i] = pz;}
+#ifdef CRENGINE_MATH_SSE
+	inline void store(int i, __m128 px, __m128 py, __m128 pz) const {_mm_storeu_ps(x + i, px); _mm_storeu_ps(y + i, py); _mm_storeu_ps(z + i, pz);}
+#endif
+};
+
+//the upper 3x4 part of a matrix, copied out so the kernels don't reload it through possibly aliased outputs
+struct Affine {
+	float m[3][4];		//rows: 3 linear coefficients and the translation
+
+	Affine(const Matrix4D &mat) {
+		for (int r = 0; r < 3; ++r)
+			for (int c = 0; c < 4; ++c)
+				m[r][c] = mat(r, c);
+	}
+
+	Affine(const Matrix3D &mat) {
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 3; ++c)
+				m[r][c] = mat(r, c);
+			m[r][3] = 0.0f;
+		}
+	}
+};
+
+/*
+the scan over [first, last) shared by all the kernels: visit4(i, x, y, z) for every 4 points
+(with sse), then visit1(i, x, y, z) for each of the remaining ones
+*/
+template<class Points, class Visit4, class Visit1>
+static inline void scan_points(const Points &points, int first, int last, const Visit4 &visit4, const Visit1 &visit1) {
+	int i = first;
+#ifdef CRENGINE_MATH_SSE
+	for (; i + 4 <= last; i += 4) {
+		__m128 x, y, z;
+		points.load(i, x, y, z);
+		visit4(i, x, y, z);
+	}
+#endif
+	for (; i < last; ++i) {
+		float x, y, z;
+		points.get(i, x, y, z);
+		visit1(i, x, y, z);
+	}
+}
+
+template<class Points, class Output>
+static void transform(const Affine &a, const Points &points, int count, const Output &out, int threads) {
+	for_each_range(count, range_count(count, threads), [&](int, int first, int last) {
+		scan_points(points, first, last,
+#ifdef CRENGINE_MATH_SSE
+			[&](int i, __m128 x, __m128 y, __m128 z) {
+				__m128 row[3];
+				for (int r = 0; r < 3; ++r)
+					row[r] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a.m[r][0]), x), _mm_mul_ps(_mm_set1_ps(a.m[r][1]), y)), _mm_mul_ps(_mm_set1_ps(a.m[r][2]), z)), _mm_set1_ps(a.m[r][3]));
+				out.store(i, row[0], row[1], row[2]);
+			},
+#else
+			[](int, float, float, float) {},
+#endif
+			[&](int i, float x, float y, float z) {
+				out.set(i, a.m[0][0] * x + a.m[0][1] * y + a.m[0][2] * z + a.m[0][3], a.m[1][0] * x + a.m[1][1] * y + a.m[1][2] * z + a.m[1][3], a.m[2][0] * x + a.m[2][1] * y + a.m[2][2] * z + a.m[2][3]);
+			}
+		);
+	});
+}
+
+#ifdef CRENGINE_MATH_SSE
+static inline __m128 squared_distances(const Vector3D &point, __m128 x, __m128 y, __m128 z) {
+	__m128 dx = _mm_sub_ps(x, _mm_set1_ps(point[0])), dy = _mm_sub_ps(y, _mm_set1_ps(point[1])), dz = _mm_sub_ps(z, _mm_set1_ps(point[2]));
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+}
+#endif
+
+static inline float squared_distance(const Vector3D &point, float x, float y, float z) {
+	float dx = x - point[0], dy = y - point[1], dz = z - point[2];
+	return dx * dx + dy * dy + dz * dz;
+}
+
+template<class Points>
+static void distances(const Vector3D &point, const Points &points, int count, float *out, int threads) {
+	for_each_range(count, range_count(count, threads), [&](int, int first, int last) {
+		scan_points(points, first, last,
+#ifdef CRENGINE_MATH_SSE
+			[&](int i, __m128 x, __m128 y, __m128 z) {_mm_storeu_ps(out + i, _mm_sqrt_ps(squared_distances(point, x, y, z)));},
+#else
+			[](int, float, float, float) {},
+#endif
+			[&](int i, float x, float y, float z) {out[i] = sqrt(squared_distance(point, x, y, z));}
+		);
+	});
+}
+
+template<class Points>
+static int within_radius(const Vector3D &point, const Points &points, int count, float radius, int threads) {
+	int ranges = range_count(count, threads);
+	int found[MAX_RANGES];
+	float squared_radius = radius * radius;
+	for_each_range(count, ranges, [&](int r, int first, int last) {
+		int n = 0;
+		scan_points(points, first, last,
+#ifdef CRENGINE_MATH_SSE
+			[&](int, __m128 x, __m128 y, __m128 z) {
+				n += __builtin_popcount(_mm_movemask_ps(_mm_cmple_ps(squared_distances(point, x, y, z), _mm_set1_ps(squared_radius))));
+			},
+#else
+			[](int, float, float, float) {},
+#endif
+			[&](int, float x, float y, float z) {n += squared_distance(point, x, y, z) <= squared_radius;}
+		);
+		found[r] = n;
+	});
+
+	int total = 0;
+	for (int r = 0; r < ranges; ++r)
+		total += found[r];
+	return total;
+}
+
+template<class Points>
+static int farthest(const Vector3D &point, const Points &points, int count, int threads) {
+	int ranges = range_count(count, threads);
+	std::pair<float, int> best[MAX_RANGES];
+	for_each_range(count, ranges, [&](int r, int first, int last) {
+		best[r] = std::pair<float, int>(-1.0f, -1);
+		//squared distances of a block go to a buffer, which is only searched when its maximum wins
+		float block[KERNEL_BLOCK], block_max;
+		for (int start = first; start < last; start += KERNEL_BLOCK) {
+			int end = std::min(start + KERNEL_BLOCK, last);
+			block_max = -1.0f;
+#ifdef CRENGINE_MATH_SSE
+			__m128 lanes_max = _mm_set1_ps(-1.0f);
+#endif
+			scan_points(points, start, end,
+#ifdef CRENGINE_MATH_SSE
+				[&](int i, __m128 x, __m128 y, __m128 z) {
+					//NaN lanes become -inf, _mm_max_ps would return a NaN operand's other operand and
+					//drop the maximum, where the scalar std::max skips the NaN
+					__m128 d = squared_distances(point, x, y, z);
+					__m128 ordered = _mm_cmpord_ps(d, d);
+					d = _mm_or_ps(_mm_and_ps(ordered, d), _mm_andnot_ps(ordered, _mm_set1_ps(-INFINITY)));
+					_mm_storeu_ps(block + i - start, d);
+					lanes_max = _mm_max_ps(lanes_max, d);
+				},
+#else
+				[](int, float, float, float) {},
+#endif
+				[&](int i, float x, float y, float z) {
+					block[i - start] = squared_distance(point, x, y, z);
+					block_max = std::max(block_max, block[i - start]);
+				}
+			);
+#ifdef CRENGINE_MATH_SSE
+			lanes_max = _mm_max_ps(lanes_max, _mm_shuffle_ps(lanes_max, lanes_max, _MM_SHUFFLE(2, 3, 0, 1)));
+			lanes_max = _mm_max_ps(lanes_max, _mm_shuffle_ps(lanes_max, lanes_max, _MM_SHUFFLE(1, 0, 3, 2)));
+			block_max = std::max(block_max, _mm_cvtss_f32(lanes_max));
+#endif
+			if (block_max > best[r].first)
+				best[r] = std::pair<float, int>(block_max, start + (std::find(block, block + end - start, block_max) - block));
+		}
+	});
+
+	//ranges are in order, so keeping the first of equal maxima keeps the lowest index
+	std::pair<float, int> result = best[0];
+	for (int r = 1; r < ranges; ++r)
+		if (best[r].first > result.first) result = best[r];
+	//no distance compares greater than -1 when they are all NaN
+	return count > 0 && result.second < 0 ? 0 : result.second;
+}
+
+template<class Points>
+static Vector3D mean(const Points &points, int count, int threads) {
+	if (count <= 0) return Vector3D();
+
+	int ranges = range_count(count, threads);
+	double sums[MAX_RANGES][3];
+	for_each_range(count, ranges, [&](int r, int first, int last) {
+		sums[r][0] = sums[r][1] = sums[r][2] = 0.0;
+		//float sums per block, added up in double
+		for (int start = first; start < last; start += KERNEL_BLOCK) {
+			float sum[3] = {0.0f, 0.0f, 0.0f};
+#ifdef CRENGINE_MATH_SSE
+			__m128 lanes[3] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+#endif
+			scan_points(points, start, std::min(start + KERNEL_BLOCK, last),
+#ifdef CRENGINE_MATH_SSE
+				[&](int, __m128 x, __m128 y, __m128 z) {
+					lanes[0] = _mm_add_ps(lanes[0], x);
+					lanes[1] = _mm_add_ps(lanes[1], y);
+					lanes[2] = _mm_add_ps(lanes[2], z);
+				},
+#else
+				[](int, float, float, float) {},
+#endif
+				[&](int, float x, float y, float z) {sum[0] += x; sum[1] += y; sum[2] += z;}
+			);
+			for (int c = 0; c < 3; ++c) {
+#ifdef CRENGINE_MATH_SSE
+				float l[4];
+				_mm_storeu_ps(l, lanes[c]);
+				sum[c] += (l[0] + l[1]) + (l[2] + l[3]);
+#endif
+				sums[r][c] += sum[c];
+			}
+		}
+	});
+
+	double total[3] = {0.0, 0.0, 0.0};
+	for (int r = 0; r < ranges; ++r)
+		for (int c = 0; c < 3; ++c)
+			total[c] += sums[r][c];
+	return Vector3D(total[0] / count, total[1] / count, total[2] / count);
+}
+
+void Math::transform_points(const Matrix4D &mat, const Vector3D *points, int count, Vector3D *out, int threads) {
+	transform(Affine(mat), PackedPoints{points}, count, PackedOutput{out}, threads);
+}
+
+void Math::transform_points(const Matrix3D &mat, const Vector3D *points, int count, Vector3D *out, int threads) {
+	transform(Affine(mat), PackedPoints{points}, count, PackedOutput{out}, threads);
+}
+
+void Math::transform_points(const Matrix4D &mat, const float *x, const float *y, const float *z, int count, float *out_x, float *out_y, float *out_z, int threads) {
+	transform(Affine(mat), SplitPoints{x, y, z}, count, SplitOutput{out_x, out_y, out_z}, threads);
+}
+
+void Math::distances_to(const Vector3D &point, const Vector3D *points, int count, float *out, int threads) {
+	distances(point, PackedPoints{points}, count, out, threads);
+}
+
+void Math::distances_to(const Vector3D &point, const float *x, const float *y, const float *z, int count, float *out, int threads) {
+	distances(point, SplitPoints{x, y, z}, count, out, threads);
+}
+
+int Math::count_within_radius(const Vector3D &point, const Vector3D *points, int count, float radius, int threads) {
+	return within_radius(point, PackedPoints{points}, count, radius, threads);
+}
+
+int Math::count_within_radius(const Vector3D &point, const float *x, const float *y, const float *z, int count, float radius, int threads) {
+	return within_radius(point, SplitPoints{x, y, z}, count, radius, threads);
+}
+
+int Math::argmax_distance(const Vector3D &point, const Vector3D *points, int count, int threads) {
+	return farthest(point, PackedPoints{points}, count, threads);
+}
+
+int Math::argmax_distance(const Vector3D &point, const float *x, const float *y, const float *z, int count, int threads) {
+	return farthest(point, SplitPoints{x, y, z}, count, threads);
+}
+
+Vector3D Math::centroid(const Vector3D *points, int count, int threads) {
+	return mean(PackedPoints{points}, count, threads);
+}
+
+Vector3D Math::centroid(const float *x, const float *y, const float *z, int count, int threads) {
+	return mean(SplitPoints{x, y, z}, count, threads);
+}
@@ -8,6 +8,10 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
@@ -28,33 +32,6 @@ static std::string read_file(const std::string &filePath) {
 	return output;
 }
 
-static std::vector<std::string> split_string(const std::string &text, const char split) {
-	size_t start = 0, end = 0;
-	const char *t = text.c_str();
-	size_t len = text.length();
-	
-	std::vector<std::string> vec;
-	
-	while(t[start] == split && start < len) start++;
-	end = start;
-	
-	while(end < len) {
-		if(t[end] == split){
-			vec.push_back(text.substr(start, end - start));
-			while(t[end] == split){
-				if(end == len - 1) return vec;
-				end++;
-			}
-			start = end;
-		}
-		end++;
-	}
-	
-	vec.push_back(text.substr(start, end - start));
-	
-	return vec;
-}
-
 using namespace CREngine::RenderUtils;
 
 //Texture			
@@ -284,70 +261,382 @@ const Font::Glyph *Font::get_glyph(char c) const {
 	return &glyphs[(int) c];
 }
 
+//Layout
+unsigned int Layout::bytes() const {
+	unsigned int component;
+	switch (type) {
+		case GL_HALF_FLOAT: component = 2; break;
+		case GL_BYTE:
+		case GL_UNSIGNED_BYTE: component = 1; break;
+		case GL_INT_2_10_10_10_REV: return 4;
+		default: component = 4; break;
+	}
+	return (size * component + 3) / 4 * 4;
+}
+
+//rounds to the nearest half float (ties to even), out of range values become infinities
+static uint16_t float_to_half(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	uint16_t sign = (bits >> 16) & 0x8000;
+	int exponent = (int) ((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	if (((bits >> 23) & 0xff) == 0xff) return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);	//inf, nan
+	if (exponent >= 31) return sign | 0x7c00;
+	if (exponent <= 0) {
+		//subnormal
+		if (exponent < -10) return sign;
+		mantissa |= 0x800000;
+		int shift = 14 - exponent;
+		return sign | (uint16_t) ((mantissa + (1 << (shift - 1)) - 1 + ((mantissa >> shift) & 1)) >> shift);
+	}
+	//a carry out of the mantissa correctly moves to the next exponent
+	return sign | (uint16_t) ((((uint32_t) exponent << 23 | mantissa) + 0xfff + ((mantissa >> 13) & 1)) >> 13);
+}
+
+static int normalized_int(float value, float scale, float min, float max) {
+	return (int) std::lround(std::min(std::max(value, min), max) * scale);
+}
+
+//writes the layout's components from values into out
+static void encode(const Layout &layout, const float *values, unsigned char *out) {
+	switch (layout.type) {
+		case GL_HALF_FLOAT: {
+			uint16_t halves[4];
+			for (int i = 0; i < layout.size; ++i) halves[i] = float_to_half(values[i]);
+			std::memcpy(out, halves, layout.size * sizeof(uint16_t));
+			break;
+		}
+		case GL_BYTE:
+			for (int i = 0; i < layout.size; ++i)
+				out[i] = (unsigned char) (int8_t) (layout.normalized ? normalized_int(values[i], 127.0f, -1.0f, 1.0f) : (int) values[i]);
+			break;
+		case GL_UNSIGNED_BYTE:
+			for (int i = 0; i < layout.size; ++i)
+				out[i] = (unsigned char) (layout.normalized ? normalized_int(values[i], 255.0f, 0.0f, 1.0f) : (int) values[i]);
+			break;
+		case GL_INT_2_10_10_10_REV: {
+			float scale = layout.normalized ? 511.0f : 1.0f;
+			uint32_t packed = 0;
+			for (int i = 0; i < 3; ++i)
+				packed |= (uint32_t) (normalized_int(values[i], scale, -512.0f / scale, 511.0f / scale) & 0x3ff) << (10 * i);
+			packed |= (uint32_t) (normalized_int(values[3], 1.0f, -2.0f, 1.0f) & 0x3) << 30;
+			std::memcpy(out, &packed, sizeof(packed));
+			break;
+		}
+		default:
+			std::memcpy(out, values, layout.size * sizeof(float));
+			break;
+	}
+}
+
+static std::vector<Layout> float_layouts(const std::vector<int> &layouts_sizes) {
+	return std::vector<Layout>(layouts_sizes.begin(), layouts_sizes.end());
+}
+
 //Batcher
 Batcher::Batcher() : Batcher("") {
 
 }
 
-Batcher::Batcher(const std::string &name) : Nameable(name), max_size(0), current_size(0), VAO(0), VBO(0), mode(GL_TRIANGLES) {}
+Batcher::Batcher(const std::string &name) : Nameable(name), max_size(0), current_size(0), vertex_size(0), gpu_size(0), VAO(0), VBO(0), streaming(false), persistent(false), writing(false), mapped(nullptr), region(0), draw_region(0), draw_size(0), fences(), mode(GL_TRIANGLES) {}
 
 Batcher::~Batcher() {
+	for (GLsync fence : fences)
+		if (fence != nullptr) glDeleteSync(fence);
 	glDeleteVertexArrays(1, &VAO);
 	glDeleteBuffers(1, &VBO);
 }
 
-void Batcher::init(unsigned int max_number_of_elements, const std::vector<int> &layouts_sizes) {
-	layouts_total_size = 0;
-	for (int s : layouts_sizes) layouts_total_size += s;
+//creates VAO and VBO, and leaves them bound
+void Batcher::init_vertex_array(const std::vector<Layout> &layouts) {
+	this->layouts = layouts;
+	vertex_size = 0;
+	for (const Layout &layout : layouts) vertex_size += layout.bytes();
 
-	max_size = layouts_total_size * max_number_of_elements * sizeof(float);
-	buffer = std::shared_ptr<float>(new float[max_size]);
-	
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 	
 	glBindVertexArray(VAO);
-
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, max_size, nullptr, GL_DYNAMIC_DRAW);
 
-	int previous = 0;
-	for (int i = 0; i < layouts_sizes.size(); ++i) {
+	unsigned int previous = 0;
+	for (int i = 0; i < layouts.size(); ++i) {
 		glEnableVertexAttribArray(i);
-		glVertexAttribPointer(i, layouts_sizes[i], GL_FLOAT, GL_FALSE, layouts_total_size * sizeof(float), (void*) (previous * sizeof(float)));
-		previous += layouts_sizes[i];
-		
+		glVertexAttribPointer(i, layouts[i].size, layouts[i].type, layouts[i].normalized ? GL_TRUE : GL_FALSE, vertex_size, (void*) (uintptr_t) previous);
+		previous += layouts[i].bytes();
 	}
+}
+
+void Batcher::init(unsigned int max_number_of_elements, const std::vector<Layout> &layouts) {
+	init_vertex_array(layouts);
+
+	max_size = vertex_size * max_number_of_elements;
+	buffer.resize(max_size);
+
+	glBufferData(GL_ARRAY_BUFFER, max_size, nullptr, GL_DYNAMIC_DRAW);
+	gpu_size = max_size;
 	
 	glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void Batcher::add_data(float *data, unsigned int data_length) {
-	std::copy(data, data + data_length, buffer.get() + current_size);
-	current_size += data_length;
+void Batcher::init(unsigned int max_number_of_elements, const std::vector<int> &layouts_sizes) {
+	init(max_number_of_elements, float_layouts(layouts_sizes));
+}
+
+void Batcher::init_streaming(unsigned int max_number_of_elements, const std::vector<Layout> &layouts) {
+	init_vertex_array(layouts);
+
+	max_size = vertex_size * max_number_of_elements;
+	streaming = true;
+	persistent = GLEW_ARB_buffer_storage;
+
+	if (persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		gpu_size = max_size * STREAM_REGIONS;
+		glBufferStorage(GL_ARRAY_BUFFER, gpu_size, nullptr, flags);
+		mapped = (unsigned char *) glMapBufferRange(GL_ARRAY_BUFFER, 0, gpu_size, flags);
+	} else {
+		gpu_size = max_size;
+		glBufferData(GL_ARRAY_BUFFER, gpu_size, nullptr, GL_STREAM_DRAW);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Batcher::init_streaming(unsigned int max_number_of_elements, const std::vector<int> &layouts_sizes) {
+	init_streaming(max_number_of_elements, float_layouts(layouts_sizes));
+}
+
+//starts writing the next content of a streaming batcher
+void Batcher::begin_write() {
+	if (writing) return;
+	writing = true;
+	current_size = 0;
+
+	if (persistent) {
+		region = (draw_region + 1) % STREAM_REGIONS;
+		if (fences[region] != nullptr) {
+			//the gpu may still be drawing from this region
+			while (glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+			glDeleteSync(fences[region]);
+			fences[region] = nullptr;
+		}
+	} else {
+		//orphan the storage, draws that still read the old one keep it alive
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, gpu_size, nullptr, GL_STREAM_DRAW);
+		mapped = (unsigned char *) glMapBufferRange(GL_ARRAY_BUFFER, 0, gpu_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+//room for size bytes after the current data, nullptr when it doesn't fit in max_size
+unsigned char *Batcher::reserve_bytes(unsigned int size) {
+	if (size > max_size - current_size) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Batcher %s is full: %u of %u bytes used, %u more requested", get_name().c_str(), current_size, max_size, size);
+		return nullptr;
+	}
+	if (!streaming) return buffer.data() + current_size;
+
+	begin_write();
+	return mapped + region * max_size + current_size;
+}
+
+float *Batcher::reserve(unsigned int data_length) {
+	return (float *) reserve_bytes(data_length * sizeof(float));
+}
+
+void Batcher::commit(unsigned int data_length) {
+	current_size += data_length * sizeof(float);
+}
+
+void Batcher::add_data(const float *data, unsigned int data_length) {
+	float *out = reserve(data_length);
+	if (out == nullptr) return;
+	std::copy(data, data + data_length, out);
+	commit(data_length);
+}
+
+void Batcher::add_vertices(const StridedView &view, const float *rest) {
+	//16 attributes of 4 components, the most GL_MAX_VERTEX_ATTRIBS has to allow
+	const unsigned int MAX_COMPONENTS = 64;
+	float vertex[MAX_COMPONENTS];
+	unsigned int components = 0;
+	for (const Layout &layout : layouts) components += layout.size;
+	if (components > MAX_COMPONENTS) {
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Batcher %s: %u components per vertex, add_vertices supports %u", get_name().c_str(), components, MAX_COMPONENTS);
+		return;
+	}
+
+	//the view's floats past the layouts' components are ignored, the missing ones come from rest
+	unsigned int copied = std::min(view.components, components);
+	for (unsigned int j = copied; j < components; ++j)
+		vertex[j] = rest != nullptr ? rest[j - copied] : 0.0f;
+
+	unsigned char *out = reserve_bytes(view.count * vertex_size);
+	if (out == nullptr) return;
+	const float *in = view.data;
+	for (unsigned int i = 0; i < view.count; ++i, in += view.stride) {
+		for (unsigned int j = 0; j < copied; ++j)
+			vertex[j] = in[j];
+
+		const float *values = vertex;
+		for (const Layout &layout : layouts) {
+			encode(layout, values, out);
+			values += layout.size;
+			out += layout.bytes();
+		}
+	}
+	current_size += view.count * vertex_size;
 }
 
 void Batcher::update() {
+	if (streaming) {
+		if (writing) {
+			if (!persistent) {
+				glBindBuffer(GL_ARRAY_BUFFER, VBO);
+				glUnmapBuffer(GL_ARRAY_BUFFER);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+			}
+			draw_region = region;
+			writing = false;
+		}
+		draw_size = current_size;
+		return;
+	}
+
 	glBindVertexArray(VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	
-	glBufferData(GL_ARRAY_BUFFER, current_size * sizeof(float), buffer.get(), GL_DYNAMIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, current_size, buffer.data(), GL_DYNAMIC_DRAW);
+	gpu_size = current_size;
 	
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 }
 
+/*
+grows the buffer bound to target to at least needed bytes, keeping its first used bytes.
+the data goes through a temporary buffer so the buffer keeps its name, and the vertex arrays
+that point to it stay valid.
+*/
+static void grow_buffer(GLenum target, unsigned int used, unsigned int &size, unsigned int needed) {
+	if (needed <= size) return;
+	unsigned int new_size = std::max(needed, size * 2);
+
+	GLuint temp = 0;
+	if (used > 0) {
+		glGenBuffers(1, &temp);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, temp);
+		glBufferData(GL_COPY_WRITE_BUFFER, used, nullptr, GL_STREAM_COPY);
+		glCopyBufferSubData(target, GL_COPY_WRITE_BUFFER, 0, 0, used);
+	}
+
+	glBufferData(target, new_size, nullptr, GL_DYNAMIC_DRAW);
+	size = new_size;
+
+	if (used > 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, temp);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, target, 0, 0, used);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glDeleteBuffers(1, &temp);
+	}
+}
+
 void Batcher::clear() {
 	current_size = 0;
 }
 
 void Batcher::render() const {
 	glBindVertexArray(VAO);
-	glDrawArrays(mode, 0, current_size / layouts_total_size);
+	if (streaming) {
+		glDrawArrays(mode, draw_region * (max_size / vertex_size), draw_size / vertex_size);
+		if (persistent) {
+			//the region can be written again once these draws are done
+			if (fences[draw_region] != nullptr) glDeleteSync(fences[draw_region]);
+			fences[draw_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+	} else {
+		glDrawArrays(mode, 0, current_size / vertex_size);
+	}
+	glBindVertexArray(0);
+}
+
+//IndexedBatcher
+IndexedBatcher::IndexedBatcher() : IndexedBatcher("") {
+
+}
+
+IndexedBatcher::IndexedBatcher(const std::string &name) : Batcher(name), EBO(0), index_count(0), index_gpu_size(0) {}
+
+IndexedBatcher::~IndexedBatcher() {
+	glDeleteBuffers(1, &EBO);
+}
+
+void IndexedBatcher::init(unsigned int max_number_of_elements, unsigned int max_number_of_indices, const std::vector<Layout> &layouts) {
+	Batcher::init(max_number_of_elements, layouts);
+
+	glGenBuffers(1, &EBO);
+
+	//the element buffer binding is part of the VAO
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	index_gpu_size = max_number_of_indices * sizeof(GLuint);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_gpu_size, nullptr, GL_DYNAMIC_DRAW);
+	glBindVertexArray(0);
+
+	index_count = 0;
+}
+
+void IndexedBatcher::append_indices(const GLuint *indices, unsigned int count) {
+	if (count == 0) return;
+
+	glBindVertexArray(VAO);
+
+	grow_buffer(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(GLuint), index_gpu_size, (index_count + count) * sizeof(GLuint));
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(GLuint), count * sizeof(GLuint), indices);
+	index_count += count;
+
 	glBindVertexArray(0);
 }
 
+void IndexedBatcher::clear_indices() {
+	index_count = 0;
+}
+
+void IndexedBatcher::render() const {
+	glBindVertexArray(VAO);
+	glDrawElements(mode, index_count, GL_UNSIGNED_INT, nullptr);
+	glBindVertexArray(0);
+}
+
+//UniformBuffer
+UniformBuffer::UniformBuffer(const std::string &name) : Nameable(name), UBO(0), size(0) {}
+
+UniformBuffer::~UniformBuffer() {
+	glDeleteBuffers(1, &UBO);
+}
+
+void UniformBuffer::init(GLuint binding, unsigned int size) {
+	this->size = size;
+	glGenBuffers(1, &UBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, UBO);
+}
+
+void UniformBuffer::update(const void *data, unsigned int size, unsigned int offset) {
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
 //Shader
 Shader::Shader(const std::string &name) : Nameable(name), programID(0) {}
 
@@ -408,24 +697,24 @@ void Shader::init_from_text(const std::string &vertex_shader, const std::string
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
 
-	//read uniforms names
-	std::vector<std::string> total_lines = split_string(vertex_shader + fragment_shader, '\n');
-	for (std::string &line : total_lines) {
-		std::vector<std::string> words = split_string(line, ' ');
-		if (words[0].compare("uniform") == 0) {
-			int l = words[0].length() + words[1].length() + 2;
-			std::string ln = line.substr(l, line.length() - l);
-			std::string name = "";
-			for (char c: ln) {
-				if (c == ' ') continue;
-				if (c == ',' || c == ';') {
-					uniforms[name]= glGetUniformLocation(programID, name.c_str());
-					name = "";
-				} else {
-					name += c;
-				}
-			}
-		}
+	//read the uniforms of the program, the ones in blocks have no location and are set through buffers
+	GLint count = 0, max_length = 0;
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+	std::vector<char> name(max_length + 1);
+	for (GLint i = 0; i < count; ++i) {
+		GLint size = 0;
+		GLenum type = 0;
+		GLsizei length = 0;
+		glGetActiveUniform(programID, i, name.size(), &length, &size, &type, name.data());
+
+		std::string uniform(name.data(), length);
+		GLint location = glGetUniformLocation(programID, uniform.c_str());
+		if (location == -1) continue;
+
+		//arrays are listed as name[0]
+		if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0) uniform.resize(uniform.size() - 3);
+		uniforms[uniform] = location;
 	}
 }
 
@@ -439,32 +728,50 @@ void Shader::init_from_file(const std::string &vertex_shader_path, const std::st
 	init_from_text(read_file(vertex_shader_path), read_file(fragment_shader_path));
 }
 
+void Shader::bind_block(const std::string &name, GLuint binding) {
+	GLuint index = glGetUniformBlockIndex(programID, name.c_str());
+	if (index != GL_INVALID_INDEX) glUniformBlockBinding(programID, index, binding);
+}
+
 void Shader::bind_vec(const std::string &name, const Math::Vector2D &v) {
-	glUniform2f(get_uniform_location(name), v[0], v[1]);
+	bind_vec(get_uniform_location(name), v);
 }
 
 void Shader::bind_vec(const std::string &name, const Math::Vector3D &v) {
-	glUniform3f(get_uniform_location(name), v[0], v[1], v[2]);
+	bind_vec(get_uniform_location(name), v);
+}
+
+void Shader::bind_vec(GLint location, const Math::Vector2D &v) {
+	glUniform2f(location, v[0], v[1]);
+}
+
+void Shader::bind_vec(GLint location, const Math::Vector3D &v) {
+	glUniform3f(location, v[0], v[1], v[2]);
 }
 
 void Shader::bind_mat(const std::string &name, const Math::Matrix2D &mat) {
-	glUniformMatrix2fv(get_uniform_location(name), 1, GL_FALSE, &mat.rows[0].v[0]);
+	bind_mat(get_uniform_location(name), mat);
 }
 
-//void Shader::bind_mat(const std::string &name, const Math::Matrix3D &mat) {
-//	glUniformMatrix3fv(get_uniform_location(name), 1, GL_FALSE, &mat.rows[0].v[0]);
-//}
+void Shader::bind_mat(GLint location, const Math::Matrix2D &mat) {
+	glUniformMatrix2fv(location, 1, GL_FALSE, &mat.rows[0].v[0]);
+}
+
+void Shader::bind_mat(const std::string &name, const Math::Matrix3D &mat) {
+	bind_mat(get_uniform_location(name), mat);
+}
+
+void Shader::bind_mat(GLint location, const Math::Matrix3D &mat) {
+	//matrices are stored column-major, as gl expects them
+	glUniformMatrix3fv(location, 1, GL_FALSE, mat.data());
+}
 
 void Shader::bind_mat(const std::string &name, const Math::Matrix4D &mat) {
-	//float data[16];
-	float data[4][4];
-	for (int i = 0, count = 0; i < 4; ++i)
-		for (int j = 0; j < 4; ++j)
-			//data[count++] = mat[i][j];
-			data[i][j] = mat[i][j];
-	
-	//glUniformMatrix4fv(get_uniform_location(name), 1, GL_FALSE, &mat.rows[0].v[0]);
-	glUniformMatrix4fv(get_uniform_location(name), 1, GL_TRUE, &data[0][0]);
+	bind_mat(get_uniform_location(name), mat);
+}
+
+void Shader::bind_mat(GLint location, const Math::Matrix4D &mat) {
+	glUniformMatrix4fv(location, 1, GL_FALSE, mat.data());
 }
 
 
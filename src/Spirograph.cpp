@@ -0,0 +1,366 @@
+#include <CREngine/Spirograph.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace CREngine;
+using namespace CREngine::Math;
+
+//number of incremental steps before a handle rotation is rebuilt from its exact angle
+static const int RESYNC_INTERVAL = 256;
+
+//parallel traces are split into chunks of this many samples (a multiple of RESYNC_INTERVAL)
+static const int CHUNK_SIZE = RESYNC_INTERVAL * 64;
+
+//the simd backend works on structure-of-arrays blocks of this many samples
+static const int BLOCK_SIZE = RESYNC_INTERVAL;
+
+//simd lanes, picked at compile time
+#if defined(__AVX__)
+typedef __m256 Lanes;
+static const int LANES = 8;
+static inline Lanes lanes_load(const float *p) {return _mm256_load_ps(p);}
+static inline void lanes_store(float *p, Lanes a) {_mm256_store_ps(p, a);}
+static inline Lanes lanes_set(float f) {return _mm256_set1_ps(f);}
+static inline Lanes lanes_add(Lanes a, Lanes b) {return _mm256_add_ps(a, b);}
+static inline Lanes lanes_sub(Lanes a, Lanes b) {return _mm256_sub_ps(a, b);}
+static inline Lanes lanes_mul(Lanes a, Lanes b) {return _mm256_mul_ps(a, b);}
+#elif defined(__SSE2__)
+typedef __m128 Lanes;
+static const int LANES = 4;
+static inline Lanes lanes_load(const float *p) {return _mm_load_ps(p);}
+static inline void lanes_store(float *p, Lanes a) {_mm_store_ps(p, a);}
+static inline Lanes lanes_set(float f) {return _mm_set1_ps(f);}
+static inline Lanes lanes_add(Lanes a, Lanes b) {return _mm_add_ps(a, b);}
+static inline Lanes lanes_sub(Lanes a, Lanes b) {return _mm_sub_ps(a, b);}
+static inline Lanes lanes_mul(Lanes a, Lanes b) {return _mm_mul_ps(a, b);}
+#else
+typedef float Lanes;
+static const int LANES = 1;
+static inline Lanes lanes_load(const float *p) {return *p;}
+static inline void lanes_store(float *p, Lanes a) {*p = a;}
+static inline Lanes lanes_set(float f) {return f;}
+static inline Lanes lanes_add(Lanes a, Lanes b) {return a + b;}
+static inline Lanes lanes_sub(Lanes a, Lanes b) {return a - b;}
+static inline Lanes lanes_mul(Lanes a, Lanes b) {return a * b;}
+#endif
+
+/*
+per handle constants used by the trace kernels.
+every handle i starts at (origins[i], 0, 0) when no rotation is applied, and rotates around
+the unit axis axes[i] by speeds[i] * time.
+*/
+struct HandleConstants {
+	int n;
+	float length;
+	std::vector<Vector3D> axes;
+	std::vector<float> origins, speeds, delta_cos, delta_sin;
+
+	HandleConstants(const Spirograph::Structure &structure, float step_delta) : n(structure.size()), length(0.0f), axes(n), origins(n), speeds(n), delta_cos(n), delta_sin(n) {
+		for (int i = 0; i < n; ++i) {
+			const Vector3D &axis = std::get<0>(structure[i]);
+			origins[i] = length;
+			length += std::get<1>(structure[i]);
+			speeds[i] = axis.length();
+			axes[i] = speeds[i] == 0.0f ? Vector3D() : axis / speeds[i];
+			delta_cos[i] = cos(speeds[i] * step_delta);
+			delta_sin[i] = sin(speeds[i] * step_delta);
+		}
+	}
+
+	//per handle scratch for the kernels
+	inline std::vector<float> floats() const {return std::vector<float>(n);}
+};
+
+/*
+the constants of the scalar kernel for exactly N handles, in fixed size arrays.
+the loops over handles get a compile time trip count, so they are fully unrolled and the
+constants stay in registers for the whole sample loop.
+*/
+template<int N>
+struct FixedHandles {
+	static const int n = N;
+	float length;
+	std::array<Vector3D, N> axes;
+	std::array<float, N> origins, speeds, delta_cos, delta_sin;
+
+	FixedHandles(const HandleConstants &h) : length(h.length) {
+		for (int i = 0; i < N; ++i) {
+			axes[i] = h.axes[i];
+			origins[i] = h.origins[i];
+			speeds[i] = h.speeds[i];
+			delta_cos[i] = h.delta_cos[i];
+			delta_sin[i] = h.delta_sin[i];
+		}
+	}
+
+	inline std::array<float, N> floats() const {return std::array<float, N>();}
+};
+
+Vector3D Spirograph::evaluate(const Structure &structure, float time) {
+	Vector3D origin;
+	for (int i = 0; i < structure.size(); ++i)
+		origin[0] += std::get<1>(structure[i]);
+
+	Vector3D head = origin;
+	for (int i = structure.size() - 1; i >= 0; --i) {
+		origin[0] -= std::get<1>(structure[i]);
+		Matrix3D rotation_matrix = Matrix3D::rotation(std::get<0>(structure[i]) * time);
+
+		head -= origin;
+		head = rotation_matrix * head;
+		head += origin;
+	}
+	return head;
+}
+
+float Spirograph::period(const Structure &structure, float max_period, float tolerance) {
+	const double two_pi = 6.283185307179586;
+
+	//a handle turns the ones after it, so only handles past the last one with a length don't matter
+	int handles = structure.size();
+	while (handles > 0 && std::get<1>(structure[handles - 1]) == 0.0f)
+		handles--;
+
+	std::vector<double> speeds;
+	double length = 0.0;
+	for (int i = 0; i < handles; ++i) {
+		double speed = std::get<0>(structure[i]).length();
+		if (speed > 0.0) speeds.push_back(speed);
+		length += std::abs(std::get<1>(structure[i]));
+	}
+	if (speeds.empty()) return 0.0f;
+
+	//every period is a whole number of turns of the slowest handle
+	double slowest = *std::min_element(speeds.begin(), speeds.end());
+	long turns = (long) (max_period * slowest / two_pi);
+	for (long k = 1; k <= turns; ++k) {
+		//turning a handle by an angle moves the head by at most angle * length
+		double drift = 0.0;
+		for (double speed : speeds) {
+			double other = speed / slowest * k;		//the handle's turns in k turns of the slowest one
+			drift += std::abs(other - std::round(other)) * two_pi * length;
+		}
+
+		//the drift adds up over every repetition up to max_period
+		double period = two_pi * k / slowest;
+		if (drift * std::floor(max_period / period) <= tolerance) return (float) period;
+	}
+	return -1.0f;
+}
+
+Vector3D Spirograph::evaluate_quaternion(const Structure &structure, float time) {
+	Quaternion chain;
+	Vector3D head;
+	for (int i = 0; i < structure.size(); ++i) {
+		chain = chain * Quaternion::rotation(std::get<0>(structure[i]) * time);
+		head += chain.x_axis() * std::get<1>(structure[i]);
+	}
+	return head;
+}
+
+/*
+writes the samples [first, last) of a trace into out[first..last).
+resyncs happen on absolute sample indices, so splitting a trace into ranges that start at
+multiples of RESYNC_INTERVAL gives exactly the same samples as tracing it in one go.
+Handles is HandleConstants, or FixedHandles<N> for a version specialized on the handle count.
+*/
+template<class Handles>
+static void trace_range_scalar(const Handles &h, float t0, float step_delta, int first, int last, Vector3D *out) {
+	const int n = h.n;
+
+	/*
+	a handle rotates around a fixed unit axis k by an angle that is linear in time, so
+	only (cos, sin) of the angle changes between samples, and advancing it by one step is
+	a constant 2d rotation by (delta_cos, delta_sin).
+	the rotation is then applied to the head directly (Rodrigues' formula) without a matrix.
+	*/
+	auto cosines = h.floats(), sines = h.floats();
+
+	for (int s = first; s < last; ++s) {
+		if (s == first || s % RESYNC_INTERVAL == 0) {
+			//rebuild the exact angles, this also keeps (cos, sin) on the unit circle
+			double time = (double) t0 + (double) s * step_delta;
+			for (int i = 0; i < n; ++i) {
+				cosines[i] = cos(h.speeds[i] * time);
+				sines[i] = sin(h.speeds[i] * time);
+			}
+		} else {
+			for (int i = 0; i < n; ++i) {
+				float c = cosines[i];
+				cosines[i] = c * h.delta_cos[i] - sines[i] * h.delta_sin[i];
+				sines[i] = sines[i] * h.delta_cos[i] + c * h.delta_sin[i];
+			}
+		}
+
+		float x = h.length, y = 0.0f, z = 0.0f;
+		for (int i = n - 1; i >= 0; --i) {
+			const float *k = h.axes[i].v;
+			float c = cosines[i], sn = sines[i];
+			x -= h.origins[i];
+			float d = (k[0] * x + k[1] * y + k[2] * z) * (1.0f - c);
+			float nx = x * c + (k[1] * z - k[2] * y) * sn + k[0] * d;
+			float ny = y * c + (k[2] * x - k[0] * z) * sn + k[1] * d;
+			float nz = z * c + (k[0] * y - k[1] * x) * sn + k[2] * d;
+			x = nx + h.origins[i]; y = ny; z = nz;
+		}
+		out[s].set(x, y, z);
+	}
+}
+
+/*
+rotates 'count' heads (rounded up to whole lanes) around the unit axis k, placed at (origin, 0, 0).
+the heads and the (cos, sin) of every head's angle are given as separate aligned arrays.
+*/
+static void rotate_block(const Vector3D &k, float origin, const float *cosines, const float *sines, float *x, float *y, float *z, int count) {
+	Lanes k0 = lanes_set(k[0]), k1 = lanes_set(k[1]), k2 = lanes_set(k[2]);
+	Lanes o = lanes_set(origin), one = lanes_set(1.0f);
+
+	for (int j = 0; j < count; j += LANES) {
+		Lanes c = lanes_load(cosines + j), s = lanes_load(sines + j);
+		Lanes hx = lanes_sub(lanes_load(x + j), o), hy = lanes_load(y + j), hz = lanes_load(z + j);
+
+		Lanes d = lanes_mul(lanes_add(lanes_add(lanes_mul(k0, hx), lanes_mul(k1, hy)), lanes_mul(k2, hz)), lanes_sub(one, c));
+		Lanes nx = lanes_add(lanes_add(lanes_mul(hx, c), lanes_mul(lanes_sub(lanes_mul(k1, hz), lanes_mul(k2, hy)), s)), lanes_mul(k0, d));
+		Lanes ny = lanes_add(lanes_add(lanes_mul(hy, c), lanes_mul(lanes_sub(lanes_mul(k2, hx), lanes_mul(k0, hz)), s)), lanes_mul(k1, d));
+		Lanes nz = lanes_add(lanes_add(lanes_mul(hz, c), lanes_mul(lanes_sub(lanes_mul(k0, hy), lanes_mul(k1, hx)), s)), lanes_mul(k2, d));
+
+		lanes_store(x + j, lanes_add(nx, o));
+		lanes_store(y + j, ny);
+		lanes_store(z + j, nz);
+	}
+}
+
+/*
+the simd version of trace_range_scalar.
+samples are processed in blocks that end on resync points, one handle at a time over the whole block.
+*/
+static void trace_range_simd(const HandleConstants &h, float t0, float step_delta, int first, int last, Vector3D *out) {
+	alignas(32) float x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE];
+	alignas(32) float cosines[BLOCK_SIZE], sines[BLOCK_SIZE];
+
+	for (int start = first; start < last; ) {
+		int end = std::min(last, (start / RESYNC_INTERVAL + 1) * RESYNC_INTERVAL);
+		int count = end - start;
+
+		std::fill(x, x + BLOCK_SIZE, h.length);
+		std::fill(y, y + BLOCK_SIZE, 0.0f);
+		std::fill(z, z + BLOCK_SIZE, 0.0f);
+
+		for (int i = h.n - 1; i >= 0; --i) {
+			//same angles as the scalar path: exact at the resync point, incremental after it
+			double time = (double) t0 + (double) start * step_delta;
+			cosines[0] = cos(h.speeds[i] * time);
+			sines[0] = sin(h.speeds[i] * time);
+			for (int j = 1; j < count; ++j) {
+				cosines[j] = cosines[j - 1] * h.delta_cos[i] - sines[j - 1] * h.delta_sin[i];
+				sines[j] = sines[j - 1] * h.delta_cos[i] + cosines[j - 1] * h.delta_sin[i];
+			}
+			std::fill(cosines + count, cosines + BLOCK_SIZE, 1.0f);
+			std::fill(sines + count, sines + BLOCK_SIZE, 0.0f);
+
+			rotate_block(h.axes[i], h.origins[i], cosines, sines, x, y, z, count);
+		}
+
+		for (int j = 0; j < count; ++j)
+			out[start + j].set(x[j], y[j], z[j]);
+		start = end;
+	}
+}
+
+//picks the scalar kernel specialized on the handle count, for up to 8 handles
+static void trace_range_scalar_dispatch(const HandleConstants &h, float t0, float step_delta, int first, int last, Vector3D *out) {
+	switch (h.n) {
+		case 1: trace_range_scalar(FixedHandles<1>(h), t0, step_delta, first, last, out); break;
+		case 2: trace_range_scalar(FixedHandles<2>(h), t0, step_delta, first, last, out); break;
+		case 3: trace_range_scalar(FixedHandles<3>(h), t0, step_delta, first, last, out); break;
+		case 4: trace_range_scalar(FixedHandles<4>(h), t0, step_delta, first, last, out); break;
+		case 5: trace_range_scalar(FixedHandles<5>(h), t0, step_delta, first, last, out); break;
+		case 6: trace_range_scalar(FixedHandles<6>(h), t0, step_delta, first, last, out); break;
+		case 7: trace_range_scalar(FixedHandles<7>(h), t0, step_delta, first, last, out); break;
+		case 8: trace_range_scalar(FixedHandles<8>(h), t0, step_delta, first, last, out); break;
+		default: trace_range_scalar(h, t0, step_delta, first, last, out);
+	}
+}
+
+static void trace_range(const HandleConstants &h, float t0, float step_delta, int first, int last, Vector3D *out, Spirograph::Backend backend) {
+	if (backend == Spirograph::SIMD)
+		trace_range_simd(h, t0, step_delta, first, last, out);
+	else
+		trace_range_scalar_dispatch(h, t0, step_delta, first, last, out);
+}
+
+void Spirograph::evaluate_batch(const Structure &structure, const float *times, int count, float *x, float *y, float *z) {
+	HandleConstants h(structure, 0.0f);
+	alignas(32) float bx[BLOCK_SIZE], by[BLOCK_SIZE], bz[BLOCK_SIZE];
+	alignas(32) float cosines[BLOCK_SIZE], sines[BLOCK_SIZE];
+
+	for (int start = 0; start < count; start += BLOCK_SIZE) {
+		int block_count = std::min(BLOCK_SIZE, count - start);
+
+		std::fill(bx, bx + BLOCK_SIZE, h.length);
+		std::fill(by, by + BLOCK_SIZE, 0.0f);
+		std::fill(bz, bz + BLOCK_SIZE, 0.0f);
+
+		for (int i = h.n - 1; i >= 0; --i) {
+			for (int j = 0; j < block_count; ++j) {
+				double angle = (double) h.speeds[i] * times[start + j];
+				cosines[j] = cos(angle);
+				sines[j] = sin(angle);
+			}
+			std::fill(cosines + block_count, cosines + BLOCK_SIZE, 1.0f);
+			std::fill(sines + block_count, sines + BLOCK_SIZE, 0.0f);
+
+			rotate_block(h.axes[i], h.origins[i], cosines, sines, bx, by, bz, block_count);
+		}
+
+		std::copy(bx, bx + block_count, x + start);
+		std::copy(by, by + block_count, y + start);
+		std::copy(bz, bz + block_count, z + start);
+	}
+}
+
+std::vector<Vector3D> Spirograph::trace(const Structure &structure, float t0, float step_delta, int steps, Backend backend) {
+	std::vector<Vector3D> points(steps > 0 ? steps : 0);
+	HandleConstants h(structure, step_delta);
+	trace_range(h, t0, step_delta, 0, points.size(), points.data(), backend);
+	return points;
+}
+
+std::vector<Vector3D> Spirograph::trace_parallel(const Structure &structure, float t0, float step_delta, int steps, int threads, Backend backend) {
+	std::vector<Vector3D> points(steps > 0 ? steps : 0);
+	HandleConstants h(structure, step_delta);
+	int chunks = (points.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+	if (threads <= 0) threads = std::thread::hardware_concurrency();
+	if (threads > chunks) threads = chunks;
+	if (threads <= 1) {
+		trace_range(h, t0, step_delta, 0, points.size(), points.data(), backend);
+		return points;
+	}
+
+	//every worker keeps taking the next untraced chunk until none are left
+	std::atomic<int> next_chunk(0);
+	auto worker = [&]() {
+		for (int c = next_chunk++; c < chunks; c = next_chunk++) {
+			int first = c * CHUNK_SIZE;
+			int last = std::min(first + CHUNK_SIZE, (int) points.size());
+			trace_range(h, t0, step_delta, first, last, points.data(), backend);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threads; ++i)
+		workers.emplace_back(worker);
+	worker();
+	for (std::thread &w : workers)
+		w.join();
+
+	return points;
+}
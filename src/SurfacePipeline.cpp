@@ -0,0 +1,186 @@
+#include <CREngine/SurfacePipeline.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace CREngine;
+
+//Parameters
+SurfacePipeline::Parameters::Parameters() :
+	backend(Spirograph::SIMD), steps(20000), step_delta(0.1f), start_time(0.001f), point_r(0.1f), angle_cos_limit(45.0f), threads(0), min_surface_likelihood(0.0f), period_tolerance(0.01f) {}
+
+//SurfacePipeline
+SurfacePipeline::SurfacePipeline(const Parameters &parameters) : parameters(parameters), total_time(parameters.start_time), trace_dimension(-1.0f), trace_period(-1.0f) {}
+
+/*
+creates a triangle and adds it to surface_triangles and surface_edges.
+returns nullptr if surface_edges rejects it.
+*/
+SurfacePipeline::Triangle *SurfacePipeline::add_triangle(Vertex *a, Vertex *b, Vertex *c) {
+	if (!surface_edges.add_triangle(a->index(), b->index(), c->index(), surface_triangles.size())) return nullptr;
+	Triangle *triangle = triangle_pool.create(a, b, c);
+	surface_triangles.push_back(triangle);
+	return triangle;
+}
+
+void SurfacePipeline::build_aoround(const Triangle &t, std::vector<Triangle *> &list) {
+	float max_angle_cos = cos(parameters.angle_cos_limit * 3.141f / 180.0f);
+
+	//iterate over edges
+	for (int i = 0; i < 3; ++i) {
+		Vertex *a = t.v[i];
+		Vertex *b = t.v[(i + 1) % 3];
+
+		//an edge that is already shared by two triangles can't take another one
+		if (surface_edges.is_closed(a->index(), b->index())) continue;
+
+		Vertex *c = nullptr;
+
+		Math::Vector3D line_normal = (*b - *a).cross(t.normal()).normalize();
+		Math::Vector3D line_center = (*b + *a) * 0.5f;
+
+		float min_distance = parameters.point_r * 10.0f;
+		float distance = 0;
+		for (uint32_t common : edge_neighbours.get(a->index(), b->index())) {	//common nearby vertices for the edge
+			Vertex *v = &vertices_list[common];
+			//the angle cosine of the vector on the triangles plane and normal to the edge
+			float angle_cos = (*v - line_center).angle_cos(line_normal);
+			if (angle_cos > max_angle_cos) {	//checking the deviation of the line direction vector
+				if (!surface_edges.can_add_triangle(a->index(), common, b->index())) continue;	//keeping the surface manifold
+
+				distance = line_center.distance_from(*v);
+				if (distance < min_distance) {		//picking the closest point which passed the filters
+					min_distance = distance;
+					c = v;
+				}
+			}
+		}
+		if (c != nullptr) {
+			list.push_back(add_triangle(a, c, b));
+		}
+	}
+}
+
+void SurfacePipeline::generate() {
+	int steps = parameters.steps;
+	trace_period = -1.0f;
+	if (parameters.period_tolerance > 0.0f) {
+		trace_period = Spirograph::period(parameters.structure, parameters.steps * parameters.step_delta, parameters.period_tolerance);
+		if (trace_period >= 0.0f) steps = std::min(steps, (int) ceil(trace_period / parameters.step_delta) + 1);
+	}
+
+	spiro_points = Spirograph::trace_parallel(parameters.structure, total_time, parameters.step_delta, steps, parameters.threads, parameters.backend);
+	total_time += steps * parameters.step_delta;
+}
+
+float SurfacePipeline::classify() {
+	trace_dimension = Geometry::intrinsic_dimension(spiro_points, parameters.point_r);
+	return surface_likelihood();
+}
+
+void SurfacePipeline::trim() {
+	trimmed_points = Geometry::thin_points(spiro_points, parameters.point_r);
+}
+
+void SurfacePipeline::create_surface() {
+	dispose();
+	if (trimmed_points.size() < 3) return;
+
+	const float point_r = parameters.point_r;
+
+	//make a copy of (Vector3D) trimmed_points to (Vertex) vertices_list
+	vertices_list.reserve(trimmed_points.size());
+	for (int i = 0; i < trimmed_points.size(); ++i) {
+		vertices_list.emplace_back(trimmed_points[i], i);
+	}
+	//calculate nerarby points
+	nearby_vertices = Geometry::radius_neighbours(trimmed_points, 3.5f * point_r);
+	edge_neighbours.init(nearby_vertices);
+
+	//calculate the gemetric center
+	Math::Vector3D center = Math::centroid(trimmed_points.data(), trimmed_points.size());
+
+	//pick the point furthest away from the center
+	int max_distance_index = Math::argmax_distance(center, trimmed_points.data(), trimmed_points.size());
+	const Math::Vector3D &max_distance_vector = vertices_list[max_distance_index];
+
+	//guess the normal for that point
+	Math::Vector3D normal = (vertices_list[max_distance_index] - center).normalize();
+
+	//find next point with minimal angle from max point
+	int min_angle_index = 0;
+	float min_angle = -1.0f;
+	for (int i = 0; i < vertices_list.size(); ++i) {
+		if (i == max_distance_index) continue;
+		Math::Vector3D &v = vertices_list[i];
+		if (v.distance_from(vertices_list[max_distance_index]) > 3.0f * point_r) continue;
+
+		float c = (vertices_list[i] - max_distance_vector).angle_cos(normal);
+
+		if (c > min_angle) {	//cosine bigger for smaller angles
+			min_angle = c;
+			min_angle_index = i;
+		}
+	}
+
+	//complete the triangle with a final point that will have minimum angle from the normal
+	float min_normal = -1.0f;
+	int min_normal_index = -1;
+	for (int i = 0; i < vertices_list.size(); ++i) {
+		if (i == max_distance_index || i == min_angle_index) continue;
+		float c = (vertices_list[i] - center).angle_cos(normal);
+		if (c >= min_normal) {	//cosine bigger for smaller angles
+			min_normal = c;
+			min_normal_index = i;
+		}
+	}
+	if (min_normal_index == -1) return;
+
+	Triangle *t = add_triangle(
+		&vertices_list[min_angle_index],
+		&vertices_list[max_distance_index],
+		&vertices_list[min_normal_index]
+	);
+
+	if (t != nullptr) active_triangles.push_back(t);
+}
+
+int SurfacePipeline::grow() {
+	int before = surface_triangles.size();
+
+	next_active_triangles.clear();
+	for (int i = 0; i < active_triangles.size(); ++i)
+		build_aoround(*active_triangles[i], next_active_triangles);
+	active_triangles.swap(next_active_triangles);
+	edge_neighbours.next_generation();
+
+	return surface_triangles.size() - before;
+}
+
+int SurfacePipeline::run(int max_growth_steps) {
+	generate();
+	if (parameters.min_surface_likelihood > 0.0f && classify() < parameters.min_surface_likelihood) {
+		trimmed_points.clear();
+		dispose();
+		return 0;
+	}
+	trim();
+	create_surface();
+
+	int growth_steps = 0;
+	while (!active_triangles.empty() && growth_steps < max_growth_steps) {
+		grow();
+		growth_steps++;
+	}
+	return growth_steps;
+}
+
+void SurfacePipeline::dispose() {
+	active_triangles.clear();
+	next_active_triangles.clear();
+	surface_triangles.clear();
+	surface_edges.clear();
+	edge_neighbours.clear();
+	triangle_pool.clear();
+	vertices_list.clear();
+}
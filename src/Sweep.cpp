@@ -0,0 +1,200 @@
+#include <CREngine/Sweep.h>
+#include <CREngine/Geometry.h>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace CREngine;
+using namespace CREngine::Math;
+using namespace CREngine::Sweep;
+
+//the configurations a worker still has to evaluate, [begin, end)
+struct WorkRange {
+	std::mutex lock;
+	long begin, end;
+};
+
+//takes the next configuration of the worker's own range
+static bool take(WorkRange &range, long &index) {
+	std::lock_guard<std::mutex> guard(range.lock);
+	if (range.begin >= range.end) return false;
+	index = range.begin++;
+	return true;
+}
+
+/*
+moves the upper half of the fullest other range into the thief's (empty) range.
+returns false when there is nothing left anywhere.
+*/
+static bool steal(std::vector<WorkRange> &ranges, int thief) {
+	int victim = -1;
+	long most = 0;
+	for (int i = 0; i < ranges.size(); ++i) {
+		if (i == thief) continue;
+		std::lock_guard<std::mutex> guard(ranges[i].lock);
+		if (ranges[i].end - ranges[i].begin > most) {
+			most = ranges[i].end - ranges[i].begin;
+			victim = i;
+		}
+	}
+	if (victim == -1) return false;
+
+	long begin, end;
+	{
+		std::lock_guard<std::mutex> guard(ranges[victim].lock);
+		long left = ranges[victim].end - ranges[victim].begin;
+		if (left <= 0) return true;		//emptied meanwhile, look again
+		end = ranges[victim].end;
+		begin = end - (left + 1) / 2;
+		ranges[victim].end = begin;
+	}
+
+	std::lock_guard<std::mutex> guard(ranges[thief].lock);
+	ranges[thief].begin = begin;
+	ranges[thief].end = end;
+	return true;
+}
+
+long Sweep::configuration_count(const Ranges &ranges) {
+	long count = (long) ranges.steps.count * ranges.step_delta.count * ranges.point_r.count;
+	for (const HandleRange &handle : ranges.handles)
+		count *= (long) handle.axis[0].count * handle.axis[1].count * handle.axis[2].count * handle.length.count;
+	return count;
+}
+
+SurfacePipeline::Parameters Sweep::configuration(const Ranges &ranges, long index) {
+	SurfacePipeline::Parameters parameters = ranges.base;
+
+	//mixed radix digits, the last range is the lowest digit
+	auto digit = [&](const Range &range) {
+		float value = range.value(index % range.count);
+		index /= range.count;
+		return value;
+	};
+	parameters.point_r = digit(ranges.point_r);
+	parameters.step_delta = digit(ranges.step_delta);
+	parameters.steps = (int) (digit(ranges.steps) + 0.5f);
+
+	parameters.structure.resize(ranges.handles.size());
+	for (int i = ranges.handles.size() - 1; i >= 0; --i) {
+		const HandleRange &handle = ranges.handles[i];
+		float length = digit(handle.length);
+		float z = digit(handle.axis[2]);
+		float y = digit(handle.axis[1]);
+		float x = digit(handle.axis[0]);
+		parameters.structure[i] = std::make_tuple(Vector3D(x, y, z), length);
+	}
+	return parameters;
+}
+
+Result Sweep::evaluate(const SurfacePipeline::Parameters &parameters, int max_growth_steps) {
+	auto start = std::chrono::steady_clock::now();
+
+	Result result;
+	result.parameters = parameters;
+	result.parameters.threads = 1;
+	SurfacePipeline pipeline(result.parameters);
+	result.growth_steps = pipeline.run(max_growth_steps);
+
+	//bounding box
+	const std::vector<Vector3D> &trace = pipeline.trace();
+	result.box_min = result.box_max = trace.empty() ? Vector3D() : trace[0];
+	for (const Vector3D &p : trace)
+		for (int c = 0; c < 3; ++c) {
+			result.box_min[c] = std::min(result.box_min[c], p[c]);
+			result.box_max[c] = std::max(result.box_max[c], p[c]);
+		}
+
+	//coverage, the vertices used by at least one triangle
+	const std::vector<SurfacePipeline::Triangle *> &triangles = pipeline.triangles();
+	std::vector<char> used(pipeline.vertices().size(), 0);
+	int used_count = 0;
+	for (const SurfacePipeline::Triangle *triangle : triangles)
+		for (int i = 0; i < 3; ++i)
+			if (!used[triangle->v[i]->index()]) {
+				used[triangle->v[i]->index()] = 1;
+				used_count++;
+			}
+
+	//surface likeness, the edges with two triangles
+	Geometry::EdgeTable<int> edges;
+	int shared = 0;
+	for (const SurfacePipeline::Triangle *triangle : triangles)
+		for (int i = 0; i < 3; ++i) {
+			uint64_t key = Geometry::EdgeTable<int>::key(triangle->v[i]->index(), triangle->v[(i + 1) % 3]->index());
+			const int *found = edges.find(key);
+			if (found == nullptr) edges.insert(key, 1);
+			else if (*found == 1) {
+				edges.insert(key, 2);
+				shared++;
+			}
+		}
+
+	result.period = pipeline.period();
+	result.dimension = pipeline.dimension();
+	result.surface_likelihood = pipeline.surface_likelihood();
+	result.meshed = parameters.min_surface_likelihood <= 0.0f || result.surface_likelihood >= parameters.min_surface_likelihood;
+	result.trimmed_points = pipeline.trimmed().size();
+	result.triangles = triangles.size();
+	result.coverage = result.trimmed_points == 0 ? 0.0f : (float) used_count / result.trimmed_points;
+	result.surface_likeness = edges.size() == 0 ? 0.0f : (float) shared / edges.size();
+	result.score = result.coverage * result.surface_likeness;
+	result.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+std::vector<Result> Sweep::run(const Ranges &ranges, int threads) {
+	long count = configuration_count(ranges);
+	std::vector<Result> results(count);
+
+	if (threads <= 0) threads = std::thread::hardware_concurrency();
+	if (threads > count) threads = count;
+	if (threads < 1) threads = 1;
+
+	//an even share for every worker
+	std::vector<WorkRange> work(threads);
+	for (int i = 0; i < threads; ++i) {
+		work[i].begin = count * i / threads;
+		work[i].end = count * (i + 1) / threads;
+	}
+
+	auto worker = [&](int id) {
+		long index;
+		for (;;) {
+			while (take(work[id], index)) {
+				results[index] = evaluate(configuration(ranges, index), ranges.max_growth_steps);
+				results[index].configuration = index;
+			}
+			if (!steal(work, id)) return;
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threads; ++i)
+		workers.emplace_back(worker, i);
+	worker(0);
+	for (std::thread &w : workers)
+		w.join();
+
+	std::stable_sort(results.begin(), results.end(), [](const Result &a, const Result &b) {return a.score > b.score;});
+	return results;
+}
+
+void Sweep::write_table(std::ostream &out, const std::vector<Result> &results) {
+	out<<"rank\tscore\tsurface_likeness\tcoverage\tdimension\tsurface_likelihood\ttriangles\ttrimmed_points\tgrowth_steps\tbox_size\tperiod\tsteps\tstep_delta\tpoint_r\tms\thandles (axis x y z, length)\tconfiguration\n";
+	for (int i = 0; i < results.size(); ++i) {
+		const Result &r = results[i];
+		Vector3D size = r.box_max - r.box_min;
+		out<<i + 1<<"\t"<<r.score<<"\t"<<r.surface_likeness<<"\t"<<r.coverage<<"\t"<<r.dimension<<"\t"<<r.surface_likelihood<<"\t"<<(r.meshed ? std::to_string(r.triangles) : "skipped")<<"\t"<<r.trimmed_points<<"\t"<<r.growth_steps<<"\t";
+		out<<size[0]<<" "<<size[1]<<" "<<size[2]<<"\t";
+		out<<(r.period < 0.0f ? "none" : std::to_string(r.period))<<"\t";
+		out<<r.parameters.steps<<"\t"<<r.parameters.step_delta<<"\t"<<r.parameters.point_r<<"\t"<<r.milliseconds<<"\t";
+		for (int h = 0; h < r.parameters.structure.size(); ++h) {
+			const Vector3D &axis = std::get<0>(r.parameters.structure[h]);
+			out<<(h == 0 ? "" : ", ")<<axis[0]<<" "<<axis[1]<<" "<<axis[2]<<" "<<std::get<1>(r.parameters.structure[h]);
+		}
+		out<<"\t"<<r.configuration<<"\n";
+	}
+}